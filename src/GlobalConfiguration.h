@@ -21,8 +21,9 @@
 #define SESSION_PATH "/home/standa/3_1_1_1/"
 #define IMAGE_PATH "../assets/haze.jpg"
 
-// Shaders section
-#define WORKGROUP_COUNT 64
+// Shaders section, workgroup sizes of the compute passes passed as specialization constants
+#define COMPUTE_GROUP_SIZE 32 // Edge of the square tiles of the per-pixel passes, a power of two
+#define COMPUTE_LINE_GROUP_SIZE 64 // Invocations of the row and column filters, every one filters a block of a line
 
 #elif DEVICE_TYPE == 1
 
@@ -35,8 +36,9 @@
 #define SESSION_PATH "/mnt/B0E0DAB9E0DA84CE/BUD/3_1_1_1/"
 #define IMAGE_PATH "../assets/image.jpg"
 
-// Shaders section
-#define WORKGROUP_COUNT 64
+// Shaders section, workgroup sizes of the compute passes passed as specialization constants
+#define COMPUTE_GROUP_SIZE 16 // Edge of the square tiles of the per-pixel passes, a power of two
+#define COMPUTE_LINE_GROUP_SIZE 64 // Invocations of the row and column filters, every one filters a block of a line
 
 #elif DEVICE_TYPE == 2
 
@@ -48,8 +50,9 @@
 #define VIDEO_DOWNSCALE_FACTOR 1
 #define SESSION_PATH "/Users/stanislavsvediroh/Downloads/1_1_1_1/"
 
-// Shaders section
-#define WORKGROUP_COUNT 24
+// Shaders section, workgroup sizes of the compute passes passed as specialization constants
+#define COMPUTE_GROUP_SIZE 16 // Edge of the square tiles of the per-pixel passes, a power of two
+#define COMPUTE_LINE_GROUP_SIZE 32 // Invocations of the row and column filters, every one filters a block of a line
 
 #endif
 
@@ -59,14 +62,36 @@
 #define WINDOW_HEIGHT 1200
 
 #define SINGLE_VIEW_MODE true
+#define TRANSFER_QUEUE_ENABLED true // Camera frames are uploaded on a dedicated transfer queue when the device has one
 
 #define TIMEZONE_OFFSET 1
 
+#define PIPELINE_CACHE_DIRECTORY "vulkan-compute-engine" // Inside the user cache directory, keeps compiled pipelines between runs
+
 #define DARK_CHANNEL_PRIOR_SHADER "ImageDarkChannelPrior"
-#define TRANSMISSION_SHADER "ImageTransmission"
 #define MAXIMUM_AIRLIGHT_SHADER "MaximumAirLight"
 #define GUIDED_FILTER_SHADER "GuidedFilter"
 #define RADIANCE_SHADER "ImageRadiance"
+#define UNPACK_SHADER "ImageUnpack"
+#define FUSED_DEHAZE_SHADER "ImageDehazeFused"
+#define MIN_FILTER_SHADER "MinFilter"
+#define SCALAR_IMAGE_FORMAT VK_FORMAT_R16_SFLOAT // Dark channel and transmission maps, don't forget to mirror it into SCALAR_FORMAT of the compute shaders
+#define SCALAR_IMAGE_FALLBACK_FORMAT VK_FORMAT_R32_SFLOAT // Used without storage support of SCALAR_IMAGE_FORMAT, shaders have an .r32f.comp variant for it
+#define RADIANCE_IMAGE_FORMAT VK_FORMAT_R8G8B8A8_UNORM // VK_FORMAT_R16G16B16A16_SFLOAT keeps the unclamped radiance, don't forget to mirror it into RADIANCE_FORMAT of ImageRadiance.comp and ImageDehazeFused.comp shaders
+#define DARK_CHANNEL_RADIUS 7 // Initial radius of the dark channel and transmission windows, adjustable in the debug GUI
+#define DARK_CHANNEL_MAX_RADIUS 25 // Sizes the shared memory of the minimum filter, keep it small for large line groups
+#define GUIDED_FILTER_RADIUS 15 // Initial guided filter window radius, adjustable in the debug GUI
+#define GUIDED_FILTER_MAX_RADIUS 60
+#define GUIDED_FILTER_EPSILON 0.001f // Initial guided filter regularization, adjustable in the debug GUI
+#define MIN_FILTER_BENCHMARK_RUNS 20 // Dispatches averaged for every radius by --benchmark-min-filter
+#define AIRLIGHT_TOP_DARK_CHANNEL_ENABLED false // Airlight from the brightest pixel among the top 0.1 % of the dark channel, instead of the dark channel maximum
+#define AIRLIGHT_HISTOGRAM_BINS 256 // Don't forget to mirror this setting into ImageDarkChannelPrior.comp shader
+#define AIRLIGHT_REDUCTION_GROUP_SIZE 256 // Power of two
+#define AIRLIGHT_CANDIDATES_PER_THREAD 4 // Workgroup candidates read by every reduction invocation
+#define FUSED_DEHAZE_GROUP_SIZE 16 // Tiles of the fused kernel stay small, their halos grow its shared memory
+#define FUSED_TRANSMISSION_RADIUS 1 // Fixed windows of the fused kernel
+#define FUSED_GUIDED_FILTER_RADIUS 1
+#define FUSED_DEHAZE_ENABLED false // Initial choice between the fused dehaze kernel and the multi-pass chain, switchable in the debug GUI
 
 // Files
 #define LEFT_VIDEO_PATH "camera_left_front/video.mp4"
@@ -74,9 +99,22 @@
 #define THERMAL_VIDEO_PATH "camera_ir/video.mp4"
 #define THERMAL_TIMESTAMPS_PATH "camera_ir/timestamps.txt"
 #define CAMERA_TIMESTAMPS_PATH "camera_left_front/timestamps.txt"
+#define RIGHT_CAMERA_TIMESTAMPS_PATH "camera_right_front/timestamps.txt"
 #define IMU_PATH "imu/imu.txt"
 #define TIME_PATH "gnss/time.txt"
 #define POSE_PATH "gnss/pose.txt"
+#define SENSOR_CACHE_PATH "sensor_logs.bin" // Binary columnar copy of the CSV logs above, created on first run
+
+// DECODING
+#define FRAME_PREFETCH_DEPTH 4 // Number of frame sets decoded ahead of the main loop
+#define FRAME_PIPELINE_ENABLED true // Decode, CPU algorithms and rendering run on consecutive frames at the same time
+#define FRAME_PIPELINE_SLOTS 4 // Datasets cycled through the pipeline, at least one per stage
+#define ZERO_COPY_DECODE_ENABLED true // Left camera frames are decoded into host visible memory the GPU uploads from
+
+// HISTORY
+#define TIMESERIES_RECENT_CAPACITY 4096 // Values kept at full resolution
+#define TIMESERIES_BUCKET_CAPACITY 1024 // Min/max/mean buckets for the older values
+#define TIMESERIES_SPILL_ENABLED false // Write the full history of every series into the session directory
 
 // IMU
 #define MAX_HEADING_DIF 3
@@ -107,8 +145,14 @@
 #define MAX_KEYPOINTS 200 // Don't forget to mirror this setting into texture.frag shader
 #define KEYPOINT_HIST_BINS 32
 
+// BATCH PROCESSING
+#define BATCH_WARMUP_FRAMES (uint32_t(4.61 / MOVING_AVERAGE_FORGET_RATE) + 1) // Frames processed before each shard range, (1 - rate)^frames < e^-4.61 leaves under 1 % of the visibility EMA start-up value, the occlusion buffers settle far sooner
+#define BATCH_CONCURRENCY 2 // Sessions processed at the same time by the batch executable
+#define BATCH_MEMORY_BUDGET_MB 16384
+
 // Debugging section
 #define TIMER_ON true
+#define GPU_TIMESTAMPS_ENABLED true // Per-stage GPU times from timestamp queries, read back once the frame's fence was waited on
 #define RENDERDOC_ENABLED false
 #define DEBUG_GUI_ENABLED true
 
@@ -6,39 +6,35 @@
 
 #include "VulkanEngineEntryPoint.h"
 #include "profiling/Timer.h"
+#include "rendering/EmbeddedShaders.h"
 #include "../external/stb/stb_image.h"
 #include "../external/stb/stb_image_write.h"
 #include <vulkan/vulkan.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <fmt/core.h>
 #include <vector>
 
-VulkanEngineEntryPoint::VulkanEngineEntryPoint(Dataset *_dataset) : dataset(_dataset) {
+VulkanEngineEntryPoint::VulkanEngineEntryPoint(Dataset *_dataset, BS::thread_pool &_pool) : dataset(_dataset),
+                                                                                          pool(_pool) {
 
-    // Init resources
-    prepareInputImage();
-    darkChannelPriorTexture.createTextureTarget(engineDevice, inputTexture);
-    transmissionTexture.createTextureTarget(engineDevice, inputTexture);
-    filteredTransmissionTexture.createTextureTarget(engineDevice, inputTexture);
-    radianceTexture.createTextureTarget(engineDevice, inputTexture);
-
-    // Buffer holding maximum airlight components for every workgroup
-    airLightGroupsBuffer = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(float),
-                                                                WORKGROUP_COUNT * WORKGROUP_COUNT * 3,
-                                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                                                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    // Buffer holding maximum airlight components of the whole image
-    airLightMaxBuffer = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(float), 3,
-                                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    queueFamilyIndices = engineDevice.findPhysicalQueueFamilies();
+    isTransferQueueUsed = engineDevice.hasDedicatedTransferQueue();
 
+    // Init resources
+    inputImageVersion++; // Uploaded by the first render()
+    prepareComputeSpecialization();
+    prepareGpuTimestamps();
+    prepareInputStagingRing();
+    prepareGuidedFilterScratch();
+    for (FrameResources &frame: frames) {
+        prepareFrameResources(frame);
+    }
 
     // Graphics
     generateQuad();
     setupVertexDescriptions();
-    prepareGraphicsUniformBuffers();
     setupDescriptorSetLayout();
     prepareGraphicsPipeline();
     setupDescriptorPool();
@@ -54,18 +50,198 @@ VulkanEngineEntryPoint::VulkanEngineEntryPoint(Dataset *_dataset) : dataset(_dat
     isRunning = true;
 }
 
-void VulkanEngineEntryPoint::prepareInputImage() {
+// Workgroup sizes of the configuration are halved until they fit the limits of the device
+void VulkanEngineEntryPoint::prepareComputeSpecialization() {
+    const VkPhysicalDeviceLimits &limits = engineDevice.properties.limits;
+    auto fitTile = [&limits](uint32_t groupSize) {
+        while (groupSize > 1 && (groupSize * groupSize > limits.maxComputeWorkGroupInvocations ||
+                                 groupSize > limits.maxComputeWorkGroupSize[0] ||
+                                 groupSize > limits.maxComputeWorkGroupSize[1])) {
+            groupSize /= 2;
+        }
+        return groupSize;
+    };
+    auto fitLine = [&limits](uint32_t groupSize, uint32_t sharedBytesPerInvocation) {
+        while (groupSize > 1 && (groupSize > limits.maxComputeWorkGroupInvocations ||
+                                 groupSize > limits.maxComputeWorkGroupSize[0] ||
+                                 groupSize * sharedBytesPerInvocation > limits.maxComputeSharedMemorySize)) {
+            groupSize /= 2;
+        }
+        return groupSize;
+    };
+
+    computeSpecialization.groupSize = fitTile(COMPUTE_GROUP_SIZE);
+    // Every minimum filter invocation keeps the suffix minimums of its block in shared memory
+    computeSpecialization.lineGroupSize = fitLine(COMPUTE_LINE_GROUP_SIZE,
+                                                  (2 * DARK_CHANNEL_MAX_RADIUS + 1) * sizeof(float));
+    computeSpecialization.reductionGroupSize = fitLine(AIRLIGHT_REDUCTION_GROUP_SIZE, sizeof(glm::vec4));
+    computeSpecialization.candidatesPerThread = AIRLIGHT_CANDIDATES_PER_THREAD;
+    computeSpecialization.maxFilterRadius = DARK_CHANNEL_MAX_RADIUS;
+    computeSpecialization.transmissionRadius = FUSED_TRANSMISSION_RADIUS;
+    computeSpecialization.guidedFilterRadius = FUSED_GUIDED_FILTER_RADIUS;
+
+    fusedDehazeSpecialization = computeSpecialization;
+    fusedDehazeSpecialization.groupSize = fitTile(FUSED_DEHAZE_GROUP_SIZE);
+}
+
+VkExtent2D VulkanEngineEntryPoint::getTileGroupCount(uint32_t groupSize) const {
+    return {(uint32_t(dataset->leftCameraFrame.cols) + groupSize - 1) / groupSize,
+            (uint32_t(dataset->leftCameraFrame.rows) + groupSize - 1) / groupSize};
+}
+
+// Camera frames are uploaded in the decoder's packed BGR layout, padded to whole 32-bit words read by the shader
+VkDeviceSize VulkanEngineEntryPoint::getInputFrameSize() const {
+    VkDeviceSize frameSize = VkDeviceSize(dataset->leftCameraFrame.cols) * dataset->leftCameraFrame.rows * 3;
+    return (frameSize + 3) & ~VkDeviceSize(3);
+}
+
+void VulkanEngineEntryPoint::prepareInputStagingRing() {
+    inputStagingRing = std::make_unique<VulkanEngineBuffer>(engineDevice, getInputFrameSize(),
+                                                            VulkanEngineSwapChain::MAX_FRAMES_IN_FLIGHT,
+                                                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                                            std::max<VkDeviceSize>(
+                                                                    engineDevice.properties.limits.optimalBufferCopyOffsetAlignment,
+                                                                    4));
+    inputStagingRing->map();
+}
+
+// Must be called after the fence of the frame was waited on, its staging region is then no longer read by the GPU
+void VulkanEngineEntryPoint::uploadInputImage(uint32_t frameIndex, VkCommandBuffer commandBuffer) {
+    FrameResources &frame = frames[frameIndex];
+    if (frame.inputImageVersion == inputImageVersion) return;
+
     Timer timer("Texture generation", &dataset->textureGeneration);
-    cv::Mat rgba;
 
-    cv::cvtColor(dataset->leftCameraFrame, rgba, cv::COLOR_BGR2RGBA);
+    // The previous copy from the frame memory has finished
+    frame.uploadedFrame.release();
+
+    // Copied as decoded, the conversion to RGBA is done by the unpack shader
+    VkBuffer sourceBuffer;
+    VkDeviceSize sourceOffset;
+    VulkanEngineBuffer *decodedBuffer = frameAllocator.findBuffer(dataset->leftCameraFrame);
+    if (decodedBuffer != nullptr && dataset->leftCameraFrame.isContinuous()) {
+        // Decoded straight into host visible memory, which the GPU copies from
+        frame.uploadedFrame = dataset->leftCameraFrame;
+        sourceBuffer = *decodedBuffer->getBuffer();
+        sourceOffset = VkDeviceSize(frame.uploadedFrame.data - frame.uploadedFrame.u->data);
+    } else {
+        sourceBuffer = *inputStagingRing->getBuffer();
+        sourceOffset = frameIndex * inputStagingRing->getAlignmentSize();
+        cv::Mat stagedImage(int(frame.inputTexture.height), int(frame.inputTexture.width), CV_8UC3,
+                            static_cast<uint8_t *>(inputStagingRing->getMappedMemory()) + sourceOffset);
+        dataset->leftCameraFrame.copyTo(stagedImage);
+    }
+
+    if (isTransferQueueUsed) {
+        VkCommandBuffer transferCommandBuffer = renderer.beginTransfer();
+        frame.inputFrameBuffer->recordCopyFrom(transferCommandBuffer, sourceBuffer, sourceOffset,
+                                               queueFamilyIndices.transferFamily, queueFamilyIndices.computeFamily);
+        renderer.submitTransfer();
 
-    inputTexture.fromImageFile(rgba.data, rgba.cols * rgba.rows * rgba.channels(), VK_FORMAT_R8G8B8A8_UNORM,
-                               rgba.cols, rgba.rows,
-                               engineDevice,
-                               engineDevice.graphicsQueue(), VK_FILTER_LINEAR,
-                               VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
-                               VK_IMAGE_LAYOUT_GENERAL);
+        frame.inputFrameBuffer->recordAcquire(commandBuffer, queueFamilyIndices.transferFamily,
+                                              queueFamilyIndices.computeFamily);
+    } else {
+        frame.inputFrameBuffer->recordCopyFrom(commandBuffer, sourceBuffer, sourceOffset);
+    }
+    frame.inputImageVersion = inputImageVersion;
+}
+
+// Compute passes of all frames run one after another on the compute queue, so a single set of scratch images is enough
+void VulkanEngineEntryPoint::prepareGuidedFilterScratch() {
+    uint32_t width = dataset->leftCameraFrame.cols;
+    uint32_t height = dataset->leftCameraFrame.rows;
+    for (Texture2D &statistics: guidedFilterStatistics) {
+        statistics.createTextureTarget(engineDevice, width, height, VK_FORMAT_R32G32B32A32_SFLOAT);
+    }
+    guidedFilterCoefficients.createTextureTarget(engineDevice, width, height, VK_FORMAT_R32G32B32A32_SFLOAT);
+}
+
+void VulkanEngineEntryPoint::destroyGuidedFilterScratch() {
+    for (Texture2D &statistics: guidedFilterStatistics) {
+        statistics.destroy(engineDevice);
+    }
+    guidedFilterCoefficients.destroy(engineDevice);
+}
+
+void VulkanEngineEntryPoint::prepareFrameResources(FrameResources &frame) {
+    frame.inputFrameBuffer = std::make_unique<VulkanEngineBuffer>(engineDevice, getInputFrameSize(), 1,
+                                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    frame.inputTexture.createTextureTarget(engineDevice, dataset->leftCameraFrame.cols, dataset->leftCameraFrame.rows);
+#if !SINGLE_VIEW_MODE
+    VkFormat scalarFormat = engineDevice.getScalarImageFormat();
+    frame.darkChannelPriorTexture.createTextureTarget(engineDevice, frame.inputTexture, scalarFormat);
+    frame.transmissionTexture.createTextureTarget(engineDevice, frame.inputTexture, scalarFormat);
+    frame.filteredTransmissionTexture.createTextureTarget(engineDevice, frame.inputTexture, scalarFormat);
+#endif
+    frame.radianceTexture.createTextureTarget(engineDevice, frame.inputTexture, RADIANCE_IMAGE_FORMAT);
+
+    // Buffer holding the airlight candidate of every workgroup, its color and the key it was selected by
+    VkExtent2D airLightGroupCount = getTileGroupCount(computeSpecialization.groupSize);
+    frame.airLightGroupsBuffer = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(glm::vec4),
+                                                                      airLightGroupCount.width *
+                                                                      airLightGroupCount.height,
+                                                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Buffer holding the brightest candidate of every chunk reduced by a single workgroup
+    frame.airLightPartialsBuffer = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(glm::vec4),
+                                                                        getAirLightPartialCount(),
+                                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Histogram of the dark channel, cleared before every use
+    frame.darkChannelHistogramBuffer = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(uint32_t),
+                                                                            AIRLIGHT_HISTOGRAM_BINS,
+                                                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                                            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // Buffer holding maximum airlight components of the whole image
+    frame.airLightMaxBuffer = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(float), 3,
+                                                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    prepareGraphicsUniformBuffers(frame);
+
+    // Built and recorded with the previous resources
+    frame.computeGraph.reset();
+    frame.isComputeChainRecorded = false;
+}
+
+void VulkanEngineEntryPoint::destroyFrameTextures(FrameResources &frame) {
+    frame.computeGraph.reset();
+    frame.inputTexture.destroy(engineDevice);
+    frame.darkChannelPriorTexture.destroy(engineDevice);
+    frame.transmissionTexture.destroy(engineDevice);
+    frame.filteredTransmissionTexture.destroy(engineDevice);
+    frame.radianceTexture.destroy(engineDevice);
+}
+
+// The camera resolution changes only between sessions, so all frames are simply recreated on an idle device
+void VulkanEngineEntryPoint::resizeInputResources() {
+    vkDeviceWaitIdle(engineDevice.getDevice());
+
+    prepareInputStagingRing();
+    destroyGuidedFilterScratch();
+    prepareGuidedFilterScratch();
+    for (FrameResources &frame: frames) {
+        destroyFrameTextures(frame);
+        prepareFrameResources(frame);
+        updateGraphicsDescriptorSets(frame);
+    }
+
+    VkExtent2D airLightGroupCount = getTileGroupCount(computeSpecialization.groupSize);
+    computePushConstant.groupCount = glm::int32_t(airLightGroupCount.width * airLightGroupCount.height);
+    computePushConstant.imageWidth = glm::int32_t(frames[0].inputTexture.width);
+    computePushConstant.imageHeight = glm::int32_t(frames[0].inputTexture.height);
 }
 
 void VulkanEngineEntryPoint::generateQuad() {
@@ -140,25 +316,25 @@ void VulkanEngineEntryPoint::setupVertexDescriptions() {
     vertices.inputState.pVertexAttributeDescriptions = vertices.attributeDescriptions.data();
 }
 
-void VulkanEngineEntryPoint::prepareGraphicsUniformBuffers() {
-    uniformBufferVertexShader = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(uboVertexShader), 1,
-                                                                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    uniformBufferFragmentShader = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(uboFragmentShader), 1,
-                                                                       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                                                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    uniformBufferVertexShader->map();
-    uniformBufferFragmentShader->map();
-
-    updateGraphicsUniformBuffers();
+void VulkanEngineEntryPoint::prepareGraphicsUniformBuffers(FrameResources &frame) {
+    frame.uniformBufferVertexShader = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(uboVertexShader), 1,
+                                                                           VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                                                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    frame.uniformBufferFragmentShader = std::make_unique<VulkanEngineBuffer>(engineDevice, sizeof(uboFragmentShader),
+                                                                             1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    frame.uniformBufferVertexShader->map();
+    frame.uniformBufferFragmentShader->map();
+
+    updateGraphicsUniformBuffers(frame);
 }
 
-void VulkanEngineEntryPoint::updateGraphicsUniformBuffers() {
+void VulkanEngineEntryPoint::updateGraphicsUniformBuffers(FrameResources &frame) {
     uboVertexShader.projection = camera.getProjection();
     uboVertexShader.modelView = camera.getView();
-    memcpy(uniformBufferVertexShader->getMappedMemory(), &uboVertexShader, sizeof(uboVertexShader));
+    memcpy(frame.uniformBufferVertexShader->getMappedMemory(), &uboVertexShader, sizeof(uboVertexShader));
 
     if (dataset != nullptr) {
         uboFragmentShader.showVanishingPoint = dataset->showVanishingPoint;
@@ -178,7 +354,7 @@ void VulkanEngineEntryPoint::updateGraphicsUniformBuffers() {
         }
     }
 
-    memcpy(uniformBufferFragmentShader->getMappedMemory(), &uboFragmentShader, sizeof(uboFragmentShader));
+    memcpy(frame.uniformBufferFragmentShader->getMappedMemory(), &uboFragmentShader, sizeof(uboFragmentShader));
 }
 
 void VulkanEngineEntryPoint::setupDescriptorSetLayout() {
@@ -285,8 +461,8 @@ void VulkanEngineEntryPoint::prepareGraphicsPipeline() {
     // Load shaders
     std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
 
-    shaderStages[0] = loadShader("../shaders/texture.vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
-    shaderStages[1] = loadShader("../shaders/texture.frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+    shaderStages[0] = loadShader("texture.vert", VK_SHADER_STAGE_VERTEX_BIT);
+    shaderStages[1] = loadShader("texture.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
 
     VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
     pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -308,8 +484,8 @@ void VulkanEngineEntryPoint::prepareGraphicsPipeline() {
     pipelineCreateInfo.pStages = shaderStages.data();
     pipelineCreateInfo.renderPass = renderer.getSwapChainRenderPass();
 
-    VK_CHECK(vkCreateGraphicsPipelines(engineDevice.getDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr,
-                                       &graphics.pipeline));
+    VK_CHECK(vkCreateGraphicsPipelines(engineDevice.getDevice(), pipelineCache.getPipelineCache(), 1,
+                                       &pipelineCreateInfo, nullptr, &graphics.pipeline));
 }
 
 void VulkanEngineEntryPoint::setupDescriptorPool() {
@@ -340,7 +516,7 @@ void VulkanEngineEntryPoint::setupDescriptorPool() {
     descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     descriptorPoolInfo.pPoolSizes = poolSizes.data();
-    descriptorPoolInfo.maxSets = 50;
+    descriptorPoolInfo.maxSets = 100;
 
     VK_CHECK(vkCreateDescriptorPool(engineDevice.getDevice(), &descriptorPoolInfo, nullptr, &descriptorPool));
 }
@@ -352,204 +528,132 @@ void VulkanEngineEntryPoint::setupDescriptorSet() {
     allocInfo.pSetLayouts = &graphics.descriptorSetLayout;
     allocInfo.descriptorSetCount = 1;
 
-    // Input image (before compute post-processing)
-    VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo, &graphics.descriptorSetPreCompute));
+    for (FrameResources &frame: frames) {
+        // Input image (before compute post-processing)
+        VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo, &frame.descriptorSetPreCompute));
+
+        // Image processing stage one
+        VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo,
+                                          &frame.descriptorSetPostComputeStageOne));
 
-    // Image processing stage one
-    VK_CHECK(
-            vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo, &graphics.descriptorSetPostComputeStageOne));
+        // Image processing stage two
+        VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo,
+                                          &frame.descriptorSetPostComputeStageTwo));
 
-    // Image processing stage two
-    VK_CHECK(
-            vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo, &graphics.descriptorSetPostComputeStageTwo));
+        // Image processing stage three
+        VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo,
+                                          &frame.descriptorSetPostComputeStageThree));
 
-    // Image processing stage three
-    VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo,
-                                      &graphics.descriptorSetPostComputeStageThree));
+        // Image processing stage four
+        VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo,
+                                          &frame.descriptorSetPostComputeStageFour));
 
-    // Image processing stage four
-    VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo,
-                                      &graphics.descriptorSetPostComputeStageFour));
+        // Final image (after compute shader processing)
+        VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo, &frame.descriptorSetPostComputeFinal));
 
-    // Final image (after compute shader processing)
-    VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo, &graphics.descriptorSetPostComputeFinal));
+        updateGraphicsDescriptorSets(frame);
+    }
+}
 
-    updateGraphicsDescriptorSets();
+// Storage image or buffer of a compute shader, arrays of images take one binding
+static VkDescriptorSetLayoutBinding computeLayoutBinding(uint32_t binding, VkDescriptorType descriptorType,
+                                                         uint32_t descriptorCount = 1) {
+    VkDescriptorSetLayoutBinding layoutBinding{};
+    layoutBinding.descriptorType = descriptorType;
+    layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    layoutBinding.binding = binding;
+    layoutBinding.descriptorCount = descriptorCount;
+    return layoutBinding;
 }
 
 void VulkanEngineEntryPoint::prepareCompute() {
-    // DarkChannelPrior calculation
-    {
-        VkDescriptorSetLayoutBinding inputImageLayoutBinding{};
-        inputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        inputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        inputImageLayoutBinding.binding = 0;
-        inputImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding outputImageLayoutBinding{};
-        outputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        outputImageLayoutBinding.binding = 1;
-        outputImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding outputAtmosphericLightLayoutBinding{};
-        outputAtmosphericLightLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        outputAtmosphericLightLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        outputAtmosphericLightLayoutBinding.binding = 2;
-        outputAtmosphericLightLayoutBinding.descriptorCount = 1;
-
-        std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
-                // Binding 0: Input image (read-only)
-                inputImageLayoutBinding,
-                // Binding 1: Output image (write)
-                outputImageLayoutBinding,
-                // Binding 2: Output atmospheric light buffer (write)
-                outputAtmosphericLightLayoutBinding,
-        };
+    const VkDescriptorType image = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    const VkDescriptorType buffer = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 
-        prepareComputePipeline(setLayoutBindings, (std::string) DARK_CHANNEL_PRIOR_SHADER);
-    }
+    // DarkChannelPrior calculation
+    prepareComputePipeline({
+                                   computeLayoutBinding(0, image), // Input image (read-only)
+                                   computeLayoutBinding(1, image), // Dark channel image (read-only)
+                                   computeLayoutBinding(2, buffer), // Atmospheric light candidates buffer (write)
+                                   computeLayoutBinding(3, buffer), // Dark channel histogram buffer (read-write)
+                           }, (std::string) DARK_CHANNEL_PRIOR_SHADER, computeSpecialization);
 
     // Maximum airLight calculation
-    {
-        VkDescriptorSetLayoutBinding inputAtmosphericLightLayoutBinding{};
-        inputAtmosphericLightLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        inputAtmosphericLightLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        inputAtmosphericLightLayoutBinding.binding = 0;
-        inputAtmosphericLightLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding outputAtmosphericLightLayoutBinding{};
-        outputAtmosphericLightLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        outputAtmosphericLightLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        outputAtmosphericLightLayoutBinding.binding = 1;
-        outputAtmosphericLightLayoutBinding.descriptorCount = 1;
-
-        std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
-                // Binding 0: Output image (read-only)
-                inputAtmosphericLightLayoutBinding,
-                // Binding 1: Output atmospheric light buffer (write)
-                outputAtmosphericLightLayoutBinding,
-        };
-
-        prepareComputePipeline(setLayoutBindings, (std::string) MAXIMUM_AIRLIGHT_SHADER);
-    }
-
-    // Transmission calculation
-    {
-        VkDescriptorSetLayoutBinding inputImageLayoutBinding{};
-        inputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        inputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        inputImageLayoutBinding.binding = 0;
-        inputImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding outputImageLayoutBinding{};
-        outputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        outputImageLayoutBinding.binding = 1;
-        outputImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding inputMaxAtmosphericLightLayoutBinding{};
-        inputMaxAtmosphericLightLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        inputMaxAtmosphericLightLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        inputMaxAtmosphericLightLayoutBinding.binding = 2;
-        inputMaxAtmosphericLightLayoutBinding.descriptorCount = 1;
-
-        std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
-                // Binding 0: Input image (read-only)
-                inputImageLayoutBinding,
-                // Binding 1: Output image (write)
-                outputImageLayoutBinding,
-                // Binding 2: Input max atmospheric light buffer (read-only)
-                inputMaxAtmosphericLightLayoutBinding
-        };
-
-        prepareComputePipeline(setLayoutBindings, (std::string) TRANSMISSION_SHADER);
-    }
+    prepareComputePipeline({
+                                   computeLayoutBinding(0, buffer), // Atmospheric light candidates buffer (read-only)
+                                   computeLayoutBinding(1, buffer), // Partial atmospheric light buffer (read-write)
+                                   computeLayoutBinding(2, buffer), // Max atmospheric light buffer (write)
+                           }, (std::string) MAXIMUM_AIRLIGHT_SHADER, computeSpecialization);
 
     // Guided Filter
-    {
-        VkDescriptorSetLayoutBinding guideImageLayoutBinding{};
-        guideImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        guideImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        guideImageLayoutBinding.binding = 0;
-        guideImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding filterInputImageLayoutBinding{};
-        filterInputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        filterInputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        filterInputImageLayoutBinding.binding = 1;
-        filterInputImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding outputImageLayoutBinding{};
-        outputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        outputImageLayoutBinding.binding = 2;
-        outputImageLayoutBinding.descriptorCount = 1;
-
-        std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
-                // Binding 0: Input Guide Image (read-only)
-                guideImageLayoutBinding,
-                // Binding 1: Input Filter Image (read-only)
-                filterInputImageLayoutBinding,
-                // Binding 2: Output Image (write)
-                outputImageLayoutBinding,
-        };
-
-        prepareComputePipeline(setLayoutBindings, (std::string) GUIDED_FILTER_SHADER);
-    }
+    prepareComputePipeline({
+                                   computeLayoutBinding(0, image), // Guide image (read-only)
+                                   computeLayoutBinding(1, image), // Filter input image (read-only)
+                                   computeLayoutBinding(2, image), // Output image (write)
+                                   // Box filtered statistics images (read-write)
+                                   computeLayoutBinding(3, image, uint32_t(guidedFilterStatistics.size())),
+                                   computeLayoutBinding(4, image), // Linear coefficients image (read-write)
+                           }, (std::string) GUIDED_FILTER_SHADER, computeSpecialization);
 
     // Radiance calculation
-    {
-        VkDescriptorSetLayoutBinding inputImageLayoutBinding{};
-        inputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        inputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        inputImageLayoutBinding.binding = 0;
-        inputImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding transmissionImageLayoutBinding{};
-        transmissionImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        transmissionImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        transmissionImageLayoutBinding.binding = 1;
-        transmissionImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding outputImageLayoutBinding{};
-        outputImageLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        outputImageLayoutBinding.binding = 2;
-        outputImageLayoutBinding.descriptorCount = 1;
-
-        VkDescriptorSetLayoutBinding inputAtmosphericLightLayoutBinding{};
-        inputAtmosphericLightLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        inputAtmosphericLightLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        inputAtmosphericLightLayoutBinding.binding = 3;
-        inputAtmosphericLightLayoutBinding.descriptorCount = 1;
-
-        std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings = {
-                // Binding 0: Input image (read-only)
-                inputImageLayoutBinding,
-                // Binding 1: Transmission image (read-only)
-                transmissionImageLayoutBinding,
-                // Binding 2: Output image (write)
-                outputImageLayoutBinding,
-                // Binding 3: Input max atmospheric light buffer (read-only)
-                inputAtmosphericLightLayoutBinding
-        };
-
-        prepareComputePipeline(setLayoutBindings, (std::string) RADIANCE_SHADER);
+    prepareComputePipeline({
+                                   computeLayoutBinding(0, image), // Input image (read-only)
+                                   computeLayoutBinding(1, image), // Transmission image (read-only)
+                                   computeLayoutBinding(2, image), // Output image (write)
+                                   computeLayoutBinding(3, buffer), // Max atmospheric light buffer (read-only)
+                           }, (std::string) RADIANCE_SHADER, computeSpecialization);
+
+    // Input frame unpacking
+    prepareComputePipeline({
+                                   computeLayoutBinding(0, buffer), // Packed BGR input frame buffer (read-only)
+                                   computeLayoutBinding(1, image), // Input image (write)
+                           }, (std::string) UNPACK_SHADER, computeSpecialization);
+
+    // Fused transmission, guided filter and radiance calculation
+    prepareComputePipeline({
+                                   computeLayoutBinding(0, image), // Input image (read-only)
+                                   computeLayoutBinding(1, image), // Transmission image (write, debug views only)
+                                   // Filtered transmission image (write, debug views only)
+                                   computeLayoutBinding(2, image),
+                                   computeLayoutBinding(3, image), // Output image (write)
+                                   computeLayoutBinding(4, buffer), // Max atmospheric light buffer (read-only)
+                           }, (std::string) FUSED_DEHAZE_SHADER, fusedDehazeSpecialization);
+
+    // Separable minimum filters, rows and columns of the dark channel and of the transmission
+    for (uint32_t pass = DarkChannelRowsPass; pass <= TransmissionColumnsPass; pass++) {
+        prepareComputePipeline({
+                                       computeLayoutBinding(0, image), // Input image (read-only), rows passes
+                                       computeLayoutBinding(1, image), // Output image (write)
+                                       // Max atmospheric light buffer (read-only), normalizes the transmission rows
+                                       computeLayoutBinding(2, buffer),
+                                       computeLayoutBinding(3, image), // Row minimum image (read-only), columns passes
+                               }, (std::string) MIN_FILTER_SHADER, computeSpecialization);
     }
 
-    updateComputeDescriptorSets();
+    // Descriptor sets are written by the compute graph of every frame, built once the pipelines exist
+    for (uint32_t i = 0; i < pendingComputePipelines.size(); i++) {
+        compute.at(i).pipeline = pendingComputePipelines[i].get();
+    }
+    pendingComputePipelines.clear();
+    // Saved right away as well, so a run which doesn't exit cleanly still leaves a warm cache behind
+    pipelineCache.save();
 
     // Push constants
-    computePushConstant.groupCount = WORKGROUP_COUNT * WORKGROUP_COUNT;
-    computePushConstant.imageWidth = glm::int32_t(inputTexture.width);
-    computePushConstant.imageHeight = glm::int32_t(inputTexture.height);
+    VkExtent2D airLightGroupCount = getTileGroupCount(computeSpecialization.groupSize);
+    computePushConstant.groupCount = glm::int32_t(airLightGroupCount.width * airLightGroupCount.height);
+    computePushConstant.imageWidth = glm::int32_t(frames[0].inputTexture.width);
+    computePushConstant.imageHeight = glm::int32_t(frames[0].inputTexture.height);
     computePushConstant.omega = 0.98;
-    computePushConstant.epsilon = 0.000001;
+    computePushConstant.epsilon = GUIDED_FILTER_EPSILON;
+    // Intermediate images are only looked at in the multi view mode
+    computePushConstant.debugOutputs = SINGLE_VIEW_MODE ? 0 : 1;
+    computePushConstant.filterRadius = DARK_CHANNEL_RADIUS;
+    computePushConstant.guidedFilterRadius = GUIDED_FILTER_RADIUS;
 }
 
 void VulkanEngineEntryPoint::prepareComputePipeline(std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings,
-                                                    const std::string &shaderName) {
+                                                    const std::string &shaderName,
+                                                    const ComputeSpecialization &specialization) {
     compute.emplace_back();
     uint32_t pipelineIndex = compute.size() - 1;
 
@@ -581,21 +685,482 @@ void VulkanEngineEntryPoint::prepareComputePipeline(std::vector<VkDescriptorSetL
     allocInfo.pSetLayouts = &compute.at(pipelineIndex).descriptorSetLayout;
     allocInfo.descriptorSetCount = 1;
 
-    VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo,
-                                      &compute.at(pipelineIndex).descriptorSet));
-
-    // Create compute shader pipelines
-    VkComputePipelineCreateInfo computePipelineCreateInfo{};
-    computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    computePipelineCreateInfo.layout = compute.at(pipelineIndex).pipelineLayout;
-    computePipelineCreateInfo.flags = 0;
-
-    std::string fileName = "../shaders/" + shaderName + ".comp.spv";
-    computePipelineCreateInfo.stage = loadShader(fileName, VK_SHADER_STAGE_COMPUTE_BIT);
-    VkPipeline pipeline;
-    VK_CHECK(vkCreateComputePipelines(engineDevice.getDevice(), VK_NULL_HANDLE, 1, &computePipelineCreateInfo, nullptr,
-                                      &pipeline));
-    compute.at(pipelineIndex).pipeline = pipeline;
+    for (FrameResources &frame: frames) {
+        VkDescriptorSet descriptorSet;
+        VK_CHECK(vkAllocateDescriptorSets(engineDevice.getDevice(), &allocInfo, &descriptorSet));
+        frame.computeDescriptorSets.push_back(descriptorSet);
+    }
+
+    // Create compute shader pipeline on the thread pool, prepareCompute() waits for all of them
+    VkDevice device = engineDevice.getDevice();
+    VkPipelineCache cache = pipelineCache.getPipelineCache();
+    VkPipelineLayout pipelineLayout = compute.at(pipelineIndex).pipelineLayout;
+    // Shaders with scalar images declare their format, so the fallback format needs their r32f variant
+    std::string fileName = shaderName + ".comp";
+    if (engineDevice.getScalarImageFormat() != SCALAR_IMAGE_FORMAT &&
+        findEmbeddedShader(shaderName + ".r32f.comp") != nullptr) {
+        fileName = shaderName + ".r32f.comp";
+    }
+    VkPipelineShaderStageCreateInfo stage = loadShader(fileName, VK_SHADER_STAGE_COMPUTE_BIT);
+    pendingComputePipelines.push_back(pool.submit([device, cache, pipelineLayout, stage, specialization]() mutable {
+        // Local sizes alias the values of the constants they come with
+        std::array<VkSpecializationMapEntry, 11> mapEntries = {{
+                {0, offsetof(ComputeSpecialization, groupSize), sizeof(uint32_t)},
+                {1, offsetof(ComputeSpecialization, groupSize), sizeof(uint32_t)},
+                {2, offsetof(ComputeSpecialization, groupSize), sizeof(uint32_t)},
+                {3, offsetof(ComputeSpecialization, lineGroupSize), sizeof(uint32_t)},
+                {4, offsetof(ComputeSpecialization, lineGroupSize), sizeof(uint32_t)},
+                {5, offsetof(ComputeSpecialization, reductionGroupSize), sizeof(uint32_t)},
+                {6, offsetof(ComputeSpecialization, reductionGroupSize), sizeof(uint32_t)},
+                {7, offsetof(ComputeSpecialization, candidatesPerThread), sizeof(uint32_t)},
+                {8, offsetof(ComputeSpecialization, maxFilterRadius), sizeof(uint32_t)},
+                {9, offsetof(ComputeSpecialization, transmissionRadius), sizeof(uint32_t)},
+                {10, offsetof(ComputeSpecialization, guidedFilterRadius), sizeof(uint32_t)},
+        }};
+        VkSpecializationInfo specializationInfo{};
+        specializationInfo.mapEntryCount = uint32_t(mapEntries.size());
+        specializationInfo.pMapEntries = mapEntries.data();
+        specializationInfo.dataSize = sizeof(ComputeSpecialization);
+        specializationInfo.pData = &specialization;
+        stage.pSpecializationInfo = &specializationInfo;
+
+        VkComputePipelineCreateInfo computePipelineCreateInfo{};
+        computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        computePipelineCreateInfo.layout = pipelineLayout;
+        computePipelineCreateInfo.flags = 0;
+        computePipelineCreateInfo.stage = stage;
+
+        // The pipeline cache is internally synchronized
+        VkPipeline pipeline;
+        VK_CHECK(vkCreateComputePipelines(device, cache, 1, &computePipelineCreateInfo, nullptr, &pipeline));
+        return pipeline;
+    }));
+}
+
+VulkanComputeGraph::Pass VulkanEngineEntryPoint::computePass(std::string name, FrameResources &frame,
+                                                             ComputePass pipeline,
+                                                             std::vector<VulkanComputeGraph::Binding> bindings,
+                                                             std::function<void(VkCommandBuffer)> record) {
+    VulkanComputeGraph::Pass pass;
+    pass.name = std::move(name);
+    pass.pipeline = compute.at(pipeline).pipeline;
+    pass.pipelineLayout = compute.at(pipeline).pipelineLayout;
+    pass.descriptorSet = frame.computeDescriptorSets.at(pipeline);
+    pass.bindings = std::move(bindings);
+    pass.record = std::move(record);
+    return pass;
+}
+
+void VulkanEngineEntryPoint::pushComputeConstants(VkCommandBuffer commandBuffer, ComputePass pipeline,
+                                                  glm::int32_t filterPass) {
+    computePushConstant.filterPass = filterPass;
+    vkCmdPushConstants(commandBuffer, compute.at(pipeline).pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(computePushConstant), &computePushConstant);
+}
+
+// Every invocation filters one block of 2 * radius + 1 pixels of a row or column
+void VulkanEngineEntryPoint::dispatchLines(VkCommandBuffer commandBuffer, bool isRowPass, glm::int32_t radius) const {
+    uint32_t blockSize = 2 * radius + 1;
+    uint32_t lineLength = isRowPass ? computePushConstant.imageWidth : computePushConstant.imageHeight;
+    uint32_t lineCount = isRowPass ? computePushConstant.imageHeight : computePushConstant.imageWidth;
+    uint32_t blockCount = (lineLength + blockSize - 1) / blockSize;
+    vkCmdDispatch(commandBuffer, (blockCount + computeSpecialization.lineGroupSize - 1) /
+                                 computeSpecialization.lineGroupSize, lineCount, 1);
+}
+
+void VulkanEngineEntryPoint::addMinFilterPasses(VulkanComputeGraph &graph, FrameResources &frame, ComputePass rowsPass,
+                                                VulkanComputeGraph::Resource input,
+                                                VulkanComputeGraph::Resource rowMinimums,
+                                                VulkanComputeGraph::Resource output,
+                                                VulkanComputeGraph::Resource airLightMax) {
+    using Access = VulkanComputeGraph::Access;
+    auto columnsPass = ComputePass(rowsPass + 1);
+    bool isTransmission = rowsPass == TransmissionRowsPass;
+
+    // Both passes bind all images of the shader, the rows read the input and the columns the row minimums
+    graph.addPass(computePass(isTransmission ? "TransmissionRows" : "DarkChannelRows", frame, rowsPass,
+                              {{0, input, Access::Read},
+                               {1, rowMinimums, Access::Write},
+                               {2, airLightMax, isTransmission ? Access::Read : Access::None},
+                               {3, rowMinimums, Access::None}},
+                              [this, rowsPass](VkCommandBuffer commandBuffer) {
+                                  pushComputeConstants(commandBuffer, rowsPass, rowsPass - DarkChannelRowsPass);
+                                  dispatchLines(commandBuffer, true, computePushConstant.filterRadius);
+                              }));
+    graph.addPass(computePass(isTransmission ? "TransmissionColumns" : "DarkChannelColumns", frame, columnsPass,
+                              {{0, input, Access::None},
+                               {1, output, Access::Write},
+                               {2, airLightMax, Access::None},
+                               {3, rowMinimums, Access::Read}},
+                              [this, columnsPass](VkCommandBuffer commandBuffer) {
+                                  pushComputeConstants(commandBuffer, columnsPass, columnsPass - DarkChannelRowsPass);
+                                  dispatchLines(commandBuffer, false, computePushConstant.filterRadius);
+                              }));
+}
+
+// Candidates of the workgroups are reduced in chunks, whose partial results are reduced by a single workgroup
+uint32_t VulkanEngineEntryPoint::getAirLightPartialCount() const {
+    uint32_t chunkSize = computeSpecialization.reductionGroupSize * computeSpecialization.candidatesPerThread;
+    VkExtent2D groupCount = getTileGroupCount(computeSpecialization.groupSize);
+    return (groupCount.width * groupCount.height + chunkSize - 1) / chunkSize;
+}
+
+std::unique_ptr<VulkanComputeGraph>
+VulkanEngineEntryPoint::buildComputeGraph(FrameResources &frame, const ComputeChainParameters &parameters) {
+    using Access = VulkanComputeGraph::Access;
+    auto graph = std::make_unique<VulkanComputeGraph>(engineDevice);
+    uint32_t width = frame.inputTexture.width;
+    uint32_t height = frame.inputTexture.height;
+    VkFormat scalarFormat = engineDevice.getScalarImageFormat();
+    auto timestamp = [this](GpuTimestamp gpuTimestamp) {
+        return [this, gpuTimestamp](VkCommandBuffer commandBuffer) {
+            writeGpuTimestamp(commandBuffer, gpuTimestamp, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        };
+    };
+
+    VulkanComputeGraph::Resource inputFrame = graph->importBuffer(*frame.inputFrameBuffer);
+    VulkanComputeGraph::Resource input = graph->importImage(frame.inputTexture);
+    VulkanComputeGraph::Resource radiance = graph->importImage(frame.radianceTexture);
+    VulkanComputeGraph::Resource airLightGroups = graph->importBuffer(*frame.airLightGroupsBuffer);
+    VulkanComputeGraph::Resource airLightPartials = graph->importBuffer(*frame.airLightPartialsBuffer);
+    VulkanComputeGraph::Resource histogram = graph->importBuffer(*frame.darkChannelHistogramBuffer);
+    VulkanComputeGraph::Resource airLightMax = graph->importBuffer(*frame.airLightMaxBuffer);
+    VulkanComputeGraph::Resource darkChannelRows = graph->createTransientImage(width, height, scalarFormat);
+    VulkanComputeGraph::Resource transmissionRows = graph->createTransientImage(width, height, scalarFormat);
+#if SINGLE_VIEW_MODE
+    // Intermediate maps are not shown, so they only live within the graph
+    VulkanComputeGraph::Resource darkChannel = graph->createTransientImage(width, height, scalarFormat);
+    VulkanComputeGraph::Resource transmission = graph->createTransientImage(width, height, scalarFormat);
+    VulkanComputeGraph::Resource filteredTransmission = graph->createTransientImage(width, height, scalarFormat);
+    Access debugOutputAccess = Access::None;
+#else
+    VulkanComputeGraph::Resource darkChannel = graph->importImage(frame.darkChannelPriorTexture);
+    VulkanComputeGraph::Resource transmission = graph->importImage(frame.transmissionTexture);
+    VulkanComputeGraph::Resource filteredTransmission = graph->importImage(frame.filteredTransmissionTexture);
+    Access debugOutputAccess = Access::Write;
+#endif
+    std::array<VulkanComputeGraph::Resource, 4> statistics{};
+    for (size_t i = 0; i < statistics.size(); i++) {
+        statistics[i] = graph->importImage(guidedFilterStatistics[i], true);
+    }
+    VulkanComputeGraph::Resource coefficients = graph->importImage(guidedFilterCoefficients, true);
+
+    // Unpack the BGR camera frame into the RGBA input image, the upload already made it visible
+    graph->addPass(computePass("Unpack", frame, UnpackPass,
+                               {{0, inputFrame, Access::Read},
+                                {1, input, Access::Write}},
+                               [this](VkCommandBuffer commandBuffer) {
+                                   pushComputeConstants(commandBuffer, UnpackPass, 0);
+                                   VkExtent2D groupCount = getTileGroupCount(computeSpecialization.groupSize);
+                                   vkCmdDispatch(commandBuffer, groupCount.width, groupCount.height, 1);
+                               }));
+    graph->addCommands(timestamp(UnpackTimestamp));
+
+    // Dark channel of the input image with the separable minimum filter
+    addMinFilterPasses(*graph, frame, DarkChannelRowsPass, input, darkChannelRows, darkChannel, airLightMax);
+    graph->addCommands(timestamp(DarkChannelTimestamp));
+
+    // Airlight candidate of every workgroup
+    auto dispatchTiles = [this](glm::int32_t filterPass) {
+        return [this, filterPass](VkCommandBuffer commandBuffer) {
+            pushComputeConstants(commandBuffer, DarkChannelPriorPass, filterPass);
+            VkExtent2D groupCount = getTileGroupCount(computeSpecialization.groupSize);
+            vkCmdDispatch(commandBuffer, groupCount.width, groupCount.height, 1);
+        };
+    };
+    if (parameters.useTopDarkChannelAirLight) {
+        // Histogram of the whole dark channel gives the threshold of its brightest 0.1 %
+        VulkanComputeGraph::Pass clearHistogram;
+        clearHistogram.name = "ClearHistogram";
+        clearHistogram.bindings = {{0, histogram, Access::Write}};
+        clearHistogram.record = [&frame](VkCommandBuffer commandBuffer) {
+            vkCmdFillBuffer(commandBuffer, *frame.darkChannelHistogramBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        };
+        graph->addPass(std::move(clearHistogram));
+
+        graph->addPass(computePass("DarkChannelHistogram", frame, DarkChannelPriorPass,
+                                   {{0, input, Access::None},
+                                    {1, darkChannel, Access::Read},
+                                    {2, airLightGroups, Access::None},
+                                    {3, histogram, Access::ReadWrite}},
+                                   dispatchTiles(1)));
+    }
+    graph->addPass(computePass("AirLightCandidates", frame, DarkChannelPriorPass,
+                               {{0, input, Access::Read},
+                                {1, darkChannel, Access::Read},
+                                {2, airLightGroups, Access::Write},
+                                {3, histogram, parameters.useTopDarkChannelAirLight ? Access::Read : Access::None}},
+                               dispatchTiles(parameters.useTopDarkChannelAirLight ? 2 : 0)));
+
+    // Brightest candidate of every chunk, then of all chunks
+    graph->addPass(computePass("AirLightPartials", frame, MaximumAirLightPass,
+                               {{0, airLightGroups, Access::Read},
+                                {1, airLightPartials, Access::Write},
+                                {2, airLightMax, Access::None}},
+                               [this](VkCommandBuffer commandBuffer) {
+                                   pushComputeConstants(commandBuffer, MaximumAirLightPass, 0);
+                                   vkCmdDispatch(commandBuffer, getAirLightPartialCount(), 1, 1);
+                               }));
+    graph->addPass(computePass("AirLightMaximum", frame, MaximumAirLightPass,
+                               {{0, airLightGroups, Access::None},
+                                {1, airLightPartials, Access::Read},
+                                {2, airLightMax, Access::Write}},
+                               [this](VkCommandBuffer commandBuffer) {
+                                   pushComputeConstants(commandBuffer, MaximumAirLightPass, 1);
+                                   vkCmdDispatch(commandBuffer, 1, 1, 1);
+                               }));
+    graph->addCommands(timestamp(AirLightTimestamp));
+
+    if (parameters.useFusedDehaze) {
+        // Transmission, its guided filtering and radiance in a single pass over shared memory tiles
+        graph->addCommands(timestamp(TransmissionTimestamp));
+        graph->addCommands(timestamp(GuidedFilterTimestamp));
+        graph->addPass(computePass("FusedDehaze", frame, FusedDehazePass,
+                                   {{0, input, Access::Read},
+                                    {1, transmission, debugOutputAccess},
+                                    {2, filteredTransmission, debugOutputAccess},
+                                    {3, radiance, Access::Write},
+                                    {4, airLightMax, Access::Read}},
+                                   [this](VkCommandBuffer commandBuffer) {
+                                       pushComputeConstants(commandBuffer, FusedDehazePass, 0);
+                                       VkExtent2D groupCount = getTileGroupCount(fusedDehazeSpecialization.groupSize);
+                                       vkCmdDispatch(commandBuffer, groupCount.width, groupCount.height, 1);
+                                   }));
+    } else {
+        // Transmission with the separable minimum filter
+        addMinFilterPasses(*graph, frame, TransmissionRowsPass, input, transmissionRows, transmission, airLightMax);
+        graph->addCommands(timestamp(TransmissionTimestamp));
+
+        // Statistics rows, coefficients columns, coefficient means rows and output columns
+        auto filterLines = [this](glm::int32_t filterPass) {
+            return [this, filterPass](VkCommandBuffer commandBuffer) {
+                pushComputeConstants(commandBuffer, GuidedFilterPass, filterPass);
+                dispatchLines(commandBuffer, filterPass % 2 == 0, computePushConstant.guidedFilterRadius);
+            };
+        };
+        graph->addPass(computePass("GuidedFilterStatistics", frame, GuidedFilterPass,
+                                   {{0, input, Access::Read},
+                                    {1, transmission, Access::Read},
+                                    {3, statistics[0], Access::Write, 0},
+                                    {3, statistics[1], Access::Write, 1},
+                                    {3, statistics[2], Access::Write, 2},
+                                    {3, statistics[3], Access::Write, 3}},
+                                   filterLines(0)));
+        graph->addPass(computePass("GuidedFilterCoefficients", frame, GuidedFilterPass,
+                                   {{3, statistics[0], Access::Read, 0},
+                                    {3, statistics[1], Access::Read, 1},
+                                    {3, statistics[2], Access::Read, 2},
+                                    {3, statistics[3], Access::Read, 3},
+                                    {4, coefficients, Access::Write}},
+                                   filterLines(1)));
+        graph->addPass(computePass("GuidedFilterCoefficientMeans", frame, GuidedFilterPass,
+                                   {{3, statistics[0], Access::Write, 0},
+                                    {4, coefficients, Access::Read}},
+                                   filterLines(2)));
+        graph->addPass(computePass("GuidedFilterOutput", frame, GuidedFilterPass,
+                                   {{0, input, Access::Read},
+                                    {2, filteredTransmission, Access::Write},
+                                    {3, statistics[0], Access::Read, 0}},
+                                   filterLines(3)));
+        graph->addCommands(timestamp(GuidedFilterTimestamp));
+
+        graph->addPass(computePass("Radiance", frame, RadiancePass,
+                                   {{0, input, Access::Read},
+                                    {1, filteredTransmission, Access::Read},
+                                    {2, radiance, Access::Write},
+                                    {3, airLightMax, Access::Read}},
+                                   [this](VkCommandBuffer commandBuffer) {
+                                       pushComputeConstants(commandBuffer, RadiancePass, 0);
+                                       VkExtent2D groupCount = getTileGroupCount(computeSpecialization.groupSize);
+                                       vkCmdDispatch(commandBuffer, groupCount.width, groupCount.height, 1);
+                                   }));
+    }
+    graph->addCommands(timestamp(RadianceTimestamp));
+
+    // Images the graphics pass samples, the intermediate maps only in the multi view mode
+    graph->markOutput(input, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    graph->markOutput(radiance, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+#if !SINGLE_VIEW_MODE
+    graph->markOutput(darkChannel, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    graph->markOutput(transmission, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    graph->markOutput(filteredTransmission, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+#endif
+    graph->compile();
+    return graph;
+}
+
+// Measures the separable dark channel filter on the current input image, the cost should not depend on the radius
+void VulkanEngineEntryPoint::benchmarkMinFilter() {
+    vkDeviceWaitIdle(engineDevice.getDevice());
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 2;
+    VkQueryPool queryPool;
+    VK_CHECK(vkCreateQueryPool(engineDevice.getDevice(), &queryPoolInfo, nullptr, &queryPool));
+
+    // The filter passes rebind the descriptor sets of the first frame, whose compute graph is built again afterwards
+    FrameResources &frame = frames[0];
+    frame.computeGraph.reset();
+    Texture2D darkChannelTexture{};
+    darkChannelTexture.createTextureTarget(engineDevice, frame.inputTexture, engineDevice.getScalarImageFormat());
+
+    VulkanComputeGraph graph(engineDevice);
+    VulkanComputeGraph::Resource input = graph.importImage(frame.inputTexture);
+    VulkanComputeGraph::Resource airLightMax = graph.importBuffer(*frame.airLightMaxBuffer);
+    VulkanComputeGraph::Resource rowMinimums = graph.createTransientImage(frame.inputTexture.width,
+                                                                          frame.inputTexture.height,
+                                                                          engineDevice.getScalarImageFormat());
+    VulkanComputeGraph::Resource darkChannel = graph.importImage(darkChannelTexture);
+    graph.addCommands([queryPool](VkCommandBuffer commandBuffer) {
+        vkCmdResetQueryPool(commandBuffer, queryPool, 0, 2);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+    });
+    for (uint32_t run = 0; run < MIN_FILTER_BENCHMARK_RUNS; run++) {
+        addMinFilterPasses(graph, frame, DarkChannelRowsPass, input, rowMinimums, darkChannel, airLightMax);
+    }
+    graph.addCommands([queryPool](VkCommandBuffer commandBuffer) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+    });
+    graph.markOutput(darkChannel, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    graph.compile();
+
+    glm::int32_t shownRadius = computePushConstant.filterRadius;
+    fmt::print("Dark channel minimum filter, {}x{} image, {} runs per radius\n", frame.inputTexture.width,
+               frame.inputTexture.height, MIN_FILTER_BENCHMARK_RUNS);
+
+    for (glm::int32_t radius = 1; radius <= DARK_CHANNEL_MAX_RADIUS; radius++) {
+        computePushConstant.filterRadius = radius;
+
+        VkCommandBuffer commandBuffer = engineDevice.beginSingleTimeCommands();
+        graph.record(commandBuffer);
+        engineDevice.endSingleTimeCommands(commandBuffer, engineDevice.graphicsQueue());
+
+        uint64_t timestamps[2];
+        VK_CHECK(vkGetQueryPoolResults(engineDevice.getDevice(), queryPool, 0, 2, sizeof(timestamps), timestamps,
+                                       sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+        double milliseconds = double(timestamps[1] - timestamps[0]) * engineDevice.properties.limits.timestampPeriod /
+                              1e6 / MIN_FILTER_BENCHMARK_RUNS;
+        fmt::print("Radius {:2} ({:2}x{:2} window): {:.3f} ms\n", radius, 2 * radius + 1, 2 * radius + 1,
+                   milliseconds);
+    }
+
+    computePushConstant.filterRadius = shownRadius;
+    darkChannelTexture.destroy(engineDevice);
+    vkDestroyQueryPool(engineDevice.getDevice(), queryPool, nullptr);
+}
+
+// Timestamps are only written when both queues the frame is recorded on support them
+void VulkanEngineEntryPoint::prepareGpuTimestamps() {
+#if GPU_TIMESTAMPS_ENABLED
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(engineDevice.getPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(engineDevice.getPhysicalDevice(), &queueFamilyCount,
+                                             queueFamilies.data());
+
+    uint32_t validBits = std::min(queueFamilies[queueFamilyIndices.computeFamily].timestampValidBits,
+                                  queueFamilies[queueFamilyIndices.graphicsFamily].timestampValidBits);
+    if (validBits == 0 || engineDevice.properties.limits.timestampPeriod == 0.0f) {
+        fmt::print("GPU timestamps are not supported, GPU stages will not be timed\n");
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = GpuTimestampCount * VulkanEngineSwapChain::MAX_FRAMES_IN_FLIGHT;
+    VK_CHECK(vkCreateQueryPool(engineDevice.getDevice(), &queryPoolInfo, nullptr, &timestampQueryPool));
+#endif
+}
+
+void VulkanEngineEntryPoint::writeGpuTimestamp(VkCommandBuffer commandBuffer, GpuTimestamp timestamp,
+                                               VkPipelineStageFlagBits stage) {
+    if (timestampQueryPool == VK_NULL_HANDLE) {
+        return;
+    }
+    vkCmdWriteTimestamp(commandBuffer, stage, timestampQueryPool,
+                        uint32_t(renderer.getFrameIndex()) * GpuTimestampCount + timestamp);
+}
+
+void VulkanEngineEntryPoint::readGpuTimestamps(FrameResources &frame) {
+    if (timestampQueryPool == VK_NULL_HANDLE || !frame.hasGpuTimestamps) {
+        return;
+    }
+
+    // The fence of the frame was already waited on, so the results are normally available. If they are not,
+    // the previous values are kept rather than waiting.
+    std::array<uint64_t, GpuTimestampCount> timestamps{};
+    VkResult result = vkGetQueryPoolResults(engineDevice.getDevice(), timestampQueryPool,
+                                            uint32_t(renderer.getFrameIndex()) * GpuTimestampCount,
+                                            GpuTimestampCount, sizeof(timestamps), timestamps.data(),
+                                            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    double timestampPeriod = engineDevice.properties.limits.timestampPeriod;
+    auto elapsed = [&](GpuTimestamp begin, GpuTimestamp end) {
+        return float(double((timestamps[end] - timestamps[begin]) & timestampMask) * timestampPeriod / 1e6);
+    };
+    dataset->gpuUnpack = elapsed(FrameStartTimestamp, UnpackTimestamp);
+    dataset->gpuDarkChannel = elapsed(UnpackTimestamp, DarkChannelTimestamp);
+    dataset->gpuAirLight = elapsed(DarkChannelTimestamp, AirLightTimestamp);
+    dataset->gpuTransmission = elapsed(AirLightTimestamp, TransmissionTimestamp);
+    dataset->gpuGuidedFilter = elapsed(TransmissionTimestamp, GuidedFilterTimestamp);
+    dataset->gpuRadiance = elapsed(GuidedFilterTimestamp, RadianceTimestamp);
+    dataset->gpuGraphics = elapsed(GraphicsStartTimestamp, GraphicsTimestamp);
+
+#if TIMER_ON
+    fmt::print("GPU stages took {:.3f} ms unpack, {:.3f} ms dark channel, {:.3f} ms airlight, {:.3f} ms transmission, "
+               "{:.3f} ms guided filter, {:.3f} ms radiance, {:.3f} ms graphics\n", dataset->gpuUnpack,
+               dataset->gpuDarkChannel, dataset->gpuAirLight, dataset->gpuTransmission, dataset->gpuGuidedFilter,
+               dataset->gpuRadiance, dataset->gpuGraphics);
+#endif
+}
+
+void VulkanEngineEntryPoint::updateComputeChain(FrameResources &frame) {
+    ComputeChainParameters parameters{computePushConstant.filterRadius, computePushConstant.guidedFilterRadius,
+                                      computePushConstant.epsilon, dataset->useFusedDehaze,
+                                      dataset->useTopDarkChannelAirLight};
+    // Radii and epsilon are only pushed as constants, the passes themselves depend on the switches
+    bool isGraphBuilt = frame.computeGraph &&
+                        frame.computeChainParameters.useFusedDehaze == parameters.useFusedDehaze &&
+                        frame.computeChainParameters.useTopDarkChannelAirLight == parameters.useTopDarkChannelAirLight;
+    if (frame.isComputeChainRecorded && isGraphBuilt && frame.computeChainParameters == parameters) {
+        return;
+    }
+
+    if (frame.computeChainCommandBuffer == VK_NULL_HANDLE) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = engineDevice.getComputeCommandPool();
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        VK_CHECK(vkAllocateCommandBuffers(engineDevice.getDevice(), &allocInfo, &frame.computeChainCommandBuffer));
+    }
+
+    // Compute passes run outside of any render pass, so nothing is inherited
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    // No longer executed by the GPU, the fence of the frame was waited on
+    frame.computeChainParameters = parameters;
+    if (!isGraphBuilt) {
+        // Transient images of the previous graph are released before the new one creates its own
+        frame.computeGraph.reset();
+        frame.computeGraph = buildComputeGraph(frame, parameters);
+    }
+    VK_CHECK(vkBeginCommandBuffer(frame.computeChainCommandBuffer, &beginInfo));
+    frame.computeGraph->record(frame.computeChainCommandBuffer);
+    VK_CHECK(vkEndCommandBuffer(frame.computeChainCommandBuffer));
+    frame.isComputeChainRecorded = true;
 }
 
 void VulkanEngineEntryPoint::render() {
@@ -603,106 +1168,34 @@ void VulkanEngineEntryPoint::render() {
 
     CommandBufferPair bufferPair = renderer.beginFrame();
     if (bufferPair.computeCommandBuffer != nullptr && bufferPair.graphicsCommandBuffer != nullptr) {
+        // The fence of this frame was waited on in beginFrame, so its resources are no longer used by the GPU
+        FrameResources &frame = frames[renderer.getFrameIndex()];
+        updateGraphicsUniformBuffers(frame);
+        readGpuTimestamps(frame);
+
         // Record compute command buffer
+        if (timestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(bufferPair.computeCommandBuffer, timestampQueryPool,
+                                uint32_t(renderer.getFrameIndex()) * GpuTimestampCount, GpuTimestampCount);
+        }
+        writeGpuTimestamp(bufferPair.computeCommandBuffer, FrameStartTimestamp, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        uploadInputImage(renderer.getFrameIndex(), bufferPair.computeCommandBuffer);
 
 #if DEBUG_GUI_ENABLED
         debugGui.showWindow(window.sdlWindow(), dataset->frameIndex, dataset);
 #endif
 
-        // First ComputeShader call -> Calculate DarkChannelPrior + maxAirLight channels for each workgroup
-        {
-            vkCmdBindPipeline(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                              compute.at(0).pipeline);
-            vkCmdBindDescriptorSets(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                    compute.at(0).pipelineLayout,
-                                    0, 1, &compute.at(0).descriptorSet, 0,
-                                    nullptr);
-
-            vkCmdPushConstants(bufferPair.computeCommandBuffer, compute.at(0).pipelineLayout,
-                               VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(computePushConstant), &computePushConstant);
-            vkCmdDispatch(bufferPair.computeCommandBuffer, WORKGROUP_COUNT, WORKGROUP_COUNT, 1);
-        }
-
-        // Wait
-        vkCmdPipelineBarrier(bufferPair.computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
-
-        // Second ComputeShader call -> Calculate maximum airLight channels on a single thread
-        {
-            vkCmdBindPipeline(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                              compute.at(1).pipeline);
-            vkCmdBindDescriptorSets(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                    compute.at(1).pipelineLayout,
-                                    0, 1, &compute.at(1).descriptorSet, 0,
-                                    nullptr);
-            vkCmdPushConstants(bufferPair.computeCommandBuffer, compute.at(1).pipelineLayout,
-                               VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(computePushConstant), &computePushConstant);
-            vkCmdDispatch(bufferPair.computeCommandBuffer, 1, 1, 1);
-        }
-
-        // Wait
-        vkCmdPipelineBarrier(bufferPair.computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
-
-        // Third ComputeShader call -> Calculate transmission
-        {
-            vkCmdBindPipeline(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                              compute.at(2).pipeline);
-            vkCmdBindDescriptorSets(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                    compute.at(2).pipelineLayout,
-                                    0, 1, &compute.at(2).descriptorSet, 0,
-                                    nullptr);
-            vkCmdPushConstants(bufferPair.computeCommandBuffer, compute.at(2).pipelineLayout,
-                               VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(computePushConstant), &computePushConstant);
-            vkCmdDispatch(bufferPair.computeCommandBuffer, WORKGROUP_COUNT, WORKGROUP_COUNT, 1);
-        }
+        computePushConstant.filterRadius = std::clamp(dataset->darkChannelRadius, 1, DARK_CHANNEL_MAX_RADIUS);
+        computePushConstant.guidedFilterRadius = std::clamp(dataset->guidedFilterRadius, 1,
+                                                            GUIDED_FILTER_MAX_RADIUS);
+        computePushConstant.epsilon = dataset->guidedFilterEpsilon;
 
-        // Wait
-        vkCmdPipelineBarrier(bufferPair.computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
-
-        // Fourth ComputeShader call -> Refine transmission with Guided filter
-        {
-            vkCmdBindPipeline(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                              compute.at(3).pipeline);
-            vkCmdBindDescriptorSets(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                    compute.at(3).pipelineLayout,
-                                    0, 1, &compute.at(3).descriptorSet, 0,
-                                    nullptr);
-            vkCmdPushConstants(bufferPair.computeCommandBuffer, compute.at(3).pipelineLayout,
-                               VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(computePushConstant), &computePushConstant);
-            vkCmdDispatch(bufferPair.computeCommandBuffer, WORKGROUP_COUNT, WORKGROUP_COUNT, 1);
-        }
+        // Compute passes, re-recorded only when something they depend on changed
+        updateComputeChain(frame);
+        vkCmdExecuteCommands(bufferPair.computeCommandBuffer, 1, &frame.computeChainCommandBuffer);
 
-        // Wait
-        vkCmdPipelineBarrier(bufferPair.computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
-
-        // Fifth ComputeShader call -> calculate radiance
-        {
-            vkCmdBindPipeline(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                              compute.at(4).pipeline);
-            vkCmdBindDescriptorSets(bufferPair.computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                    compute.at(4).pipelineLayout,
-                                    0, 1, &compute.at(4).descriptorSet, 0,
-                                    nullptr);
-
-            vkCmdPushConstants(bufferPair.computeCommandBuffer, compute.at(4).pipelineLayout,
-                               VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(computePushConstant),
-                               &computePushConstant);
-            vkCmdDispatch(bufferPair.computeCommandBuffer, WORKGROUP_COUNT, WORKGROUP_COUNT, 1);
-        }
-
-        VkMemoryBarrier memoryBarrier = {};
-        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        // Wait
-        vkCmdPipelineBarrier(bufferPair.computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                             VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
-
-        renderer.beginSwapChainRenderPass(bufferPair.graphicsCommandBuffer, radianceTexture.image);
+        writeGpuTimestamp(bufferPair.graphicsCommandBuffer, GraphicsStartTimestamp, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        renderer.beginSwapChainRenderPass(bufferPair.graphicsCommandBuffer, frame.radianceTexture.image);
         // Record graphics commandBuffer
 #if SINGLE_VIEW_MODE
         uint32_t preWidth = renderer.getEngineSwapChain()->getSwapChainExtent().width;
@@ -728,13 +1221,13 @@ void VulkanEngineEntryPoint::render() {
 
         vkCmdBindDescriptorSets(bufferPair.graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 graphics.pipelineLayout, 0, 1,
-                                &graphics.descriptorSetPreCompute, 0, nullptr);
+                                &frame.descriptorSetPreCompute, 0, nullptr);
 
         vkCmdDrawIndexed(bufferPair.graphicsCommandBuffer, indexCount, 1, 0, 0, 0);
 #else
         // Render first half of the screen
         float preWidth = float(renderer.getEngineSwapChain()->getSwapChainExtent().width) * 0.5f + zoom;
-        float preHeight = (preWidth / float(inputTexture.width)) * float(inputTexture.height);
+        float preHeight = (preWidth / float(frame.inputTexture.width)) * float(frame.inputTexture.height);
 
         VkViewport viewport = {};
         viewport.x = panPosition.x;
@@ -757,14 +1250,14 @@ void VulkanEngineEntryPoint::render() {
         // Top Left (pre compute)
         vkCmdBindDescriptorSets(bufferPair.graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 graphics.pipelineLayout, 0, 1,
-                                &graphics.descriptorSetPreCompute, 0, nullptr);
+                                &frame.descriptorSetPreCompute, 0, nullptr);
 
         vkCmdDrawIndexed(bufferPair.graphicsCommandBuffer, indexCount, 1, 0, 0, 0);
 
         // Top Right (final image)
         vkCmdBindDescriptorSets(bufferPair.graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 graphics.pipelineLayout, 0, 1,
-                                &graphics.descriptorSetPostComputeFinal, 0, nullptr);
+                                &frame.descriptorSetPostComputeFinal, 0, nullptr);
 
         viewport.x = panPosition.x + preWidth;
         vkCmdSetViewport(bufferPair.graphicsCommandBuffer, 0, 1, &viewport);
@@ -773,7 +1266,7 @@ void VulkanEngineEntryPoint::render() {
         // Middle Left (compute first stage)
         vkCmdBindDescriptorSets(bufferPair.graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 graphics.pipelineLayout, 0, 1,
-                                &graphics.descriptorSetPostComputeStageOne, 0, nullptr);
+                                &frame.descriptorSetPostComputeStageOne, 0, nullptr);
 
         viewport.x = panPosition.x;
         viewport.y = panPosition.y + preHeight;
@@ -783,7 +1276,7 @@ void VulkanEngineEntryPoint::render() {
         // Middle Right (compute second stage)
         vkCmdBindDescriptorSets(bufferPair.graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 graphics.pipelineLayout, 0, 1,
-                                &graphics.descriptorSetPostComputeStageTwo, 0, nullptr);
+                                &frame.descriptorSetPostComputeStageTwo, 0, nullptr);
 
         viewport.x = panPosition.x + preWidth;
         viewport.y = panPosition.y + preHeight;
@@ -793,7 +1286,7 @@ void VulkanEngineEntryPoint::render() {
         // Bottom Left (compute third stage)
         vkCmdBindDescriptorSets(bufferPair.graphicsCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 graphics.pipelineLayout, 0, 1,
-                                &graphics.descriptorSetPostComputeStageThree, 0, nullptr);
+                                &frame.descriptorSetPostComputeStageThree, 0, nullptr);
 
         viewport.x = panPosition.x;
         viewport.y = panPosition.y + (preHeight * 2.0f);
@@ -806,10 +1299,9 @@ void VulkanEngineEntryPoint::render() {
 #endif
 
         renderer.endSwapChainRenderPass(bufferPair.graphicsCommandBuffer);
+        writeGpuTimestamp(bufferPair.graphicsCommandBuffer, GraphicsTimestamp, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        frame.hasGpuTimestamps = true;
         renderer.endFrame(dataset);
-
-        vkQueueWaitIdle(engineDevice.graphicsQueue());
-
     }
 }
 
@@ -819,215 +1311,40 @@ void VulkanEngineEntryPoint::prepareNextFrame() {
     dataset->vanishingPoint.second = int(
             float(dataset->vanishingPoint.second * window.getExtent().height) / float(dataset->cameraHeight));
 
-    prepareInputImage();
-
-    updateGraphicsUniformBuffers();
-    updateComputeDescriptorSets();
-    updateGraphicsDescriptorSets();
-}
-
-void VulkanEngineEntryPoint::updateComputeDescriptorSets() {
-    // DarkChannelPrior calculation
-    {
-        VkWriteDescriptorSet inputImageDescriptorSet{};
-        inputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inputImageDescriptorSet.dstSet = compute.at(0).descriptorSet;
-        inputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        inputImageDescriptorSet.dstBinding = 0;
-        inputImageDescriptorSet.pImageInfo = &inputTexture.descriptor;
-        inputImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet outputImageDescriptorSet{};
-        outputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        outputImageDescriptorSet.dstSet = compute.at(0).descriptorSet;
-        outputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageDescriptorSet.dstBinding = 1;
-        outputImageDescriptorSet.pImageInfo = &darkChannelPriorTexture.descriptor;
-        outputImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet outputAirLightBufferDescriptorSet{};
-        outputAirLightBufferDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        outputAirLightBufferDescriptorSet.dstSet = compute.at(0).descriptorSet;
-        outputAirLightBufferDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        outputAirLightBufferDescriptorSet.dstBinding = 2;
-        outputAirLightBufferDescriptorSet.pBufferInfo = &airLightGroupsBuffer->getBufferInfo();
-        outputAirLightBufferDescriptorSet.descriptorCount = 1;
-
-        std::vector<VkWriteDescriptorSet> computeWriteDescriptorSets = {
-                inputImageDescriptorSet,
-                outputImageDescriptorSet,
-                outputAirLightBufferDescriptorSet,
-        };
-        vkUpdateDescriptorSets(engineDevice.getDevice(), computeWriteDescriptorSets.size(),
-                               computeWriteDescriptorSets.data(), 0, nullptr);
-    }
-
-    // Maximum airLight calculation
-    {
-        VkWriteDescriptorSet inputAirLightBufferDescriptorSet{};
-        inputAirLightBufferDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inputAirLightBufferDescriptorSet.dstSet = compute.at(1).descriptorSet;
-        inputAirLightBufferDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        inputAirLightBufferDescriptorSet.dstBinding = 0;
-        inputAirLightBufferDescriptorSet.pBufferInfo = &airLightGroupsBuffer->getBufferInfo();
-        inputAirLightBufferDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet outputAirLightBufferDescriptorSet{};
-        outputAirLightBufferDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        outputAirLightBufferDescriptorSet.dstSet = compute.at(1).descriptorSet;
-        outputAirLightBufferDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        outputAirLightBufferDescriptorSet.dstBinding = 1;
-        outputAirLightBufferDescriptorSet.pBufferInfo = &airLightMaxBuffer->getBufferInfo();
-        outputAirLightBufferDescriptorSet.descriptorCount = 1;
-
-        std::vector<VkWriteDescriptorSet> computeWriteDescriptorSets = {
-                inputAirLightBufferDescriptorSet,
-                outputAirLightBufferDescriptorSet,
-        };
-        vkUpdateDescriptorSets(engineDevice.getDevice(), computeWriteDescriptorSets.size(),
-                               computeWriteDescriptorSets.data(), 0, nullptr);
-    }
-
-    // Transmission calculation
-    {
-        VkWriteDescriptorSet inputImageDescriptorSet{};
-        inputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inputImageDescriptorSet.dstSet = compute.at(2).descriptorSet;
-        inputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        inputImageDescriptorSet.dstBinding = 0;
-        inputImageDescriptorSet.pImageInfo = &inputTexture.descriptor;
-        inputImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet outputImageDescriptorSet{};
-        outputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        outputImageDescriptorSet.dstSet = compute.at(2).descriptorSet;
-        outputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageDescriptorSet.dstBinding = 1;
-        outputImageDescriptorSet.pImageInfo = &transmissionTexture.descriptor;
-        outputImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet inputMaxAirLightBufferDescriptorSet{};
-        inputMaxAirLightBufferDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inputMaxAirLightBufferDescriptorSet.dstSet = compute.at(2).descriptorSet;
-        inputMaxAirLightBufferDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        inputMaxAirLightBufferDescriptorSet.dstBinding = 2;
-        inputMaxAirLightBufferDescriptorSet.pBufferInfo = &airLightMaxBuffer->getBufferInfo();
-        inputMaxAirLightBufferDescriptorSet.descriptorCount = 1;
-
-        std::vector<VkWriteDescriptorSet> computeWriteDescriptorSets = {
-                inputImageDescriptorSet,
-                outputImageDescriptorSet,
-                inputMaxAirLightBufferDescriptorSet,
-        };
-        vkUpdateDescriptorSets(engineDevice.getDevice(), computeWriteDescriptorSets.size(),
-                               computeWriteDescriptorSets.data(), 0, nullptr);
+    if (uint32_t(dataset->leftCameraFrame.cols) != frames[0].inputTexture.width ||
+        uint32_t(dataset->leftCameraFrame.rows) != frames[0].inputTexture.height) {
+        resizeInputResources();
     }
 
-    // Guided filter
-    {
-        VkWriteDescriptorSet guideImageDescriptorSet{};
-        guideImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        guideImageDescriptorSet.dstSet = compute.at(3).descriptorSet;
-        guideImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        guideImageDescriptorSet.dstBinding = 0;
-        guideImageDescriptorSet.pImageInfo = &inputTexture.descriptor;
-        guideImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet filterInputImageDescriptorSet{};
-        filterInputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        filterInputImageDescriptorSet.dstSet = compute.at(3).descriptorSet;
-        filterInputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        filterInputImageDescriptorSet.dstBinding = 1;
-        filterInputImageDescriptorSet.pImageInfo = &transmissionTexture.descriptor;
-        filterInputImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet outputImageDescriptorSet{};
-        outputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        outputImageDescriptorSet.dstSet = compute.at(3).descriptorSet;
-        outputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageDescriptorSet.dstBinding = 2;
-        outputImageDescriptorSet.pImageInfo = &filteredTransmissionTexture.descriptor;
-        outputImageDescriptorSet.descriptorCount = 1;
-
-        std::vector<VkWriteDescriptorSet> computeWriteDescriptorSets = {
-                guideImageDescriptorSet,
-                filterInputImageDescriptorSet,
-                outputImageDescriptorSet,
-        };
-        vkUpdateDescriptorSets(engineDevice.getDevice(), computeWriteDescriptorSets.size(),
-                               computeWriteDescriptorSets.data(), 0, nullptr);
-    }
-
-    // Radiance calculation
-    {
-        VkWriteDescriptorSet inputImageDescriptorSet{};
-        inputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inputImageDescriptorSet.dstSet = compute.at(4).descriptorSet;
-        inputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        inputImageDescriptorSet.dstBinding = 0;
-        inputImageDescriptorSet.pImageInfo = &inputTexture.descriptor;
-        inputImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet transmissionImageDescriptorSet{};
-        transmissionImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        transmissionImageDescriptorSet.dstSet = compute.at(4).descriptorSet;
-        transmissionImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        transmissionImageDescriptorSet.dstBinding = 1;
-        transmissionImageDescriptorSet.pImageInfo = &filteredTransmissionTexture.descriptor;
-        transmissionImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet outputImageDescriptorSet{};
-        outputImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        outputImageDescriptorSet.dstSet = compute.at(4).descriptorSet;
-        outputImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        outputImageDescriptorSet.dstBinding = 2;
-        outputImageDescriptorSet.pImageInfo = &radianceTexture.descriptor;
-        outputImageDescriptorSet.descriptorCount = 1;
-
-        VkWriteDescriptorSet maxAirLightBufferDescriptorSet{};
-        maxAirLightBufferDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        maxAirLightBufferDescriptorSet.dstSet = compute.at(4).descriptorSet;
-        maxAirLightBufferDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        maxAirLightBufferDescriptorSet.dstBinding = 3;
-        maxAirLightBufferDescriptorSet.pBufferInfo = &airLightMaxBuffer->getBufferInfo();
-        maxAirLightBufferDescriptorSet.descriptorCount = 1;
-
-        std::vector<VkWriteDescriptorSet> computeWriteDescriptorSets = {
-                inputImageDescriptorSet,
-                transmissionImageDescriptorSet,
-                outputImageDescriptorSet,
-                maxAirLightBufferDescriptorSet,
-        };
-        vkUpdateDescriptorSets(engineDevice.getDevice(), computeWriteDescriptorSets.size(),
-                               computeWriteDescriptorSets.data(), 0, nullptr);
-    }
+    // Uploaded and written into the uniform buffers once the frame resources are free in render()
+    inputImageVersion++;
 }
 
-void VulkanEngineEntryPoint::updateGraphicsDescriptorSets() {
+void VulkanEngineEntryPoint::updateGraphicsDescriptorSets(FrameResources &frame) {
     // Pre Compute
     {
         VkWriteDescriptorSet vertexUniformDescriptorSet{};
         vertexUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        vertexUniformDescriptorSet.dstSet = graphics.descriptorSetPreCompute;
+        vertexUniformDescriptorSet.dstSet = frame.descriptorSetPreCompute;
         vertexUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         vertexUniformDescriptorSet.dstBinding = 0;
-        vertexUniformDescriptorSet.pBufferInfo = &uniformBufferVertexShader->getBufferInfo();
+        vertexUniformDescriptorSet.pBufferInfo = &frame.uniformBufferVertexShader->getBufferInfo();
         vertexUniformDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet imageDescriptorSet{};
         imageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        imageDescriptorSet.dstSet = graphics.descriptorSetPreCompute;
+        imageDescriptorSet.dstSet = frame.descriptorSetPreCompute;
         imageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         imageDescriptorSet.dstBinding = 1;
-        imageDescriptorSet.pImageInfo = &inputTexture.descriptor;
+        imageDescriptorSet.pImageInfo = &frame.inputTexture.descriptor;
         imageDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet fragmentUniformDescriptorSet{};
         fragmentUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        fragmentUniformDescriptorSet.dstSet = graphics.descriptorSetPreCompute;
+        fragmentUniformDescriptorSet.dstSet = frame.descriptorSetPreCompute;
         fragmentUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         fragmentUniformDescriptorSet.dstBinding = 2;
-        fragmentUniformDescriptorSet.pBufferInfo = &uniformBufferFragmentShader->getBufferInfo();
+        fragmentUniformDescriptorSet.pBufferInfo = &frame.uniformBufferFragmentShader->getBufferInfo();
         fragmentUniformDescriptorSet.descriptorCount = 1;
 
         std::vector<VkWriteDescriptorSet> baseImageWriteDescriptorSets = {
@@ -1039,30 +1356,32 @@ void VulkanEngineEntryPoint::updateGraphicsDescriptorSets() {
                                baseImageWriteDescriptorSets.data(), 0, nullptr);
     }
 
+#if !SINGLE_VIEW_MODE
+    // Intermediate maps are only images of their own in the multi view mode, which shows them
     // Post-Compute first stage
     {
         VkWriteDescriptorSet inProgressVertexUniformDescriptorSet{};
         inProgressVertexUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressVertexUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageOne;
+        inProgressVertexUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageOne;
         inProgressVertexUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressVertexUniformDescriptorSet.dstBinding = 0;
-        inProgressVertexUniformDescriptorSet.pBufferInfo = &uniformBufferVertexShader->getBufferInfo();
+        inProgressVertexUniformDescriptorSet.pBufferInfo = &frame.uniformBufferVertexShader->getBufferInfo();
         inProgressVertexUniformDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressImageDescriptorSet{};
         inProgressImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressImageDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageOne;
+        inProgressImageDescriptorSet.dstSet = frame.descriptorSetPostComputeStageOne;
         inProgressImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         inProgressImageDescriptorSet.dstBinding = 1;
-        inProgressImageDescriptorSet.pImageInfo = &darkChannelPriorTexture.descriptor;
+        inProgressImageDescriptorSet.pImageInfo = &frame.darkChannelPriorTexture.displayDescriptor;
         inProgressImageDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressFragmentUniformDescriptorSet{};
         inProgressFragmentUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressFragmentUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageOne;
+        inProgressFragmentUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageOne;
         inProgressFragmentUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressFragmentUniformDescriptorSet.dstBinding = 2;
-        inProgressFragmentUniformDescriptorSet.pBufferInfo = &uniformBufferFragmentShader->getBufferInfo();
+        inProgressFragmentUniformDescriptorSet.pBufferInfo = &frame.uniformBufferFragmentShader->getBufferInfo();
         inProgressFragmentUniformDescriptorSet.descriptorCount = 1;
 
         std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
@@ -1079,26 +1398,26 @@ void VulkanEngineEntryPoint::updateGraphicsDescriptorSets() {
     {
         VkWriteDescriptorSet inProgressVertexUniformDescriptorSet{};
         inProgressVertexUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressVertexUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageTwo;
+        inProgressVertexUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageTwo;
         inProgressVertexUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressVertexUniformDescriptorSet.dstBinding = 0;
-        inProgressVertexUniformDescriptorSet.pBufferInfo = &uniformBufferVertexShader->getBufferInfo();
+        inProgressVertexUniformDescriptorSet.pBufferInfo = &frame.uniformBufferVertexShader->getBufferInfo();
         inProgressVertexUniformDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressImageDescriptorSet{};
         inProgressImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressImageDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageTwo;
+        inProgressImageDescriptorSet.dstSet = frame.descriptorSetPostComputeStageTwo;
         inProgressImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         inProgressImageDescriptorSet.dstBinding = 1;
-        inProgressImageDescriptorSet.pImageInfo = &transmissionTexture.descriptor;
+        inProgressImageDescriptorSet.pImageInfo = &frame.transmissionTexture.displayDescriptor;
         inProgressImageDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressFragmentUniformDescriptorSet{};
         inProgressFragmentUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressFragmentUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageTwo;
+        inProgressFragmentUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageTwo;
         inProgressFragmentUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressFragmentUniformDescriptorSet.dstBinding = 2;
-        inProgressFragmentUniformDescriptorSet.pBufferInfo = &uniformBufferFragmentShader->getBufferInfo();
+        inProgressFragmentUniformDescriptorSet.pBufferInfo = &frame.uniformBufferFragmentShader->getBufferInfo();
         inProgressFragmentUniformDescriptorSet.descriptorCount = 1;
 
         std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
@@ -1115,26 +1434,26 @@ void VulkanEngineEntryPoint::updateGraphicsDescriptorSets() {
     {
         VkWriteDescriptorSet inProgressVertexUniformDescriptorSet{};
         inProgressVertexUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressVertexUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageThree;
+        inProgressVertexUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageThree;
         inProgressVertexUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressVertexUniformDescriptorSet.dstBinding = 0;
-        inProgressVertexUniformDescriptorSet.pBufferInfo = &uniformBufferVertexShader->getBufferInfo();
+        inProgressVertexUniformDescriptorSet.pBufferInfo = &frame.uniformBufferVertexShader->getBufferInfo();
         inProgressVertexUniformDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressImageDescriptorSet{};
         inProgressImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressImageDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageThree;
+        inProgressImageDescriptorSet.dstSet = frame.descriptorSetPostComputeStageThree;
         inProgressImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         inProgressImageDescriptorSet.dstBinding = 1;
-        inProgressImageDescriptorSet.pImageInfo = &filteredTransmissionTexture.descriptor;
+        inProgressImageDescriptorSet.pImageInfo = &frame.filteredTransmissionTexture.displayDescriptor;
         inProgressImageDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressFragmentUniformDescriptorSet{};
         inProgressFragmentUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressFragmentUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageThree;
+        inProgressFragmentUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageThree;
         inProgressFragmentUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressFragmentUniformDescriptorSet.dstBinding = 2;
-        inProgressFragmentUniformDescriptorSet.pBufferInfo = &uniformBufferFragmentShader->getBufferInfo();
+        inProgressFragmentUniformDescriptorSet.pBufferInfo = &frame.uniformBufferFragmentShader->getBufferInfo();
         inProgressFragmentUniformDescriptorSet.descriptorCount = 1;
 
         std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
@@ -1151,26 +1470,26 @@ void VulkanEngineEntryPoint::updateGraphicsDescriptorSets() {
     {
         VkWriteDescriptorSet inProgressVertexUniformDescriptorSet{};
         inProgressVertexUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressVertexUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageFour;
+        inProgressVertexUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageFour;
         inProgressVertexUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressVertexUniformDescriptorSet.dstBinding = 0;
-        inProgressVertexUniformDescriptorSet.pBufferInfo = &uniformBufferVertexShader->getBufferInfo();
+        inProgressVertexUniformDescriptorSet.pBufferInfo = &frame.uniformBufferVertexShader->getBufferInfo();
         inProgressVertexUniformDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressImageDescriptorSet{};
         inProgressImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressImageDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageFour;
+        inProgressImageDescriptorSet.dstSet = frame.descriptorSetPostComputeStageFour;
         inProgressImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         inProgressImageDescriptorSet.dstBinding = 1;
-        inProgressImageDescriptorSet.pImageInfo = &filteredTransmissionTexture.descriptor;
+        inProgressImageDescriptorSet.pImageInfo = &frame.filteredTransmissionTexture.displayDescriptor;
         inProgressImageDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet inProgressFragmentUniformDescriptorSet{};
         inProgressFragmentUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        inProgressFragmentUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeStageFour;
+        inProgressFragmentUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeStageFour;
         inProgressFragmentUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         inProgressFragmentUniformDescriptorSet.dstBinding = 2;
-        inProgressFragmentUniformDescriptorSet.pBufferInfo = &uniformBufferFragmentShader->getBufferInfo();
+        inProgressFragmentUniformDescriptorSet.pBufferInfo = &frame.uniformBufferFragmentShader->getBufferInfo();
         inProgressFragmentUniformDescriptorSet.descriptorCount = 1;
 
         std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
@@ -1182,31 +1501,32 @@ void VulkanEngineEntryPoint::updateGraphicsDescriptorSets() {
         vkUpdateDescriptorSets(engineDevice.getDevice(), writeDescriptorSets.size(), writeDescriptorSets.data(), 0,
                                nullptr);
     }
+#endif
 
     // Post-Compute final image
     {
         VkWriteDescriptorSet postComputeVertexUniformDescriptorSet{};
         postComputeVertexUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        postComputeVertexUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeFinal;
+        postComputeVertexUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeFinal;
         postComputeVertexUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         postComputeVertexUniformDescriptorSet.dstBinding = 0;
-        postComputeVertexUniformDescriptorSet.pBufferInfo = &uniformBufferVertexShader->getBufferInfo();
+        postComputeVertexUniformDescriptorSet.pBufferInfo = &frame.uniformBufferVertexShader->getBufferInfo();
         postComputeVertexUniformDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet postImageDescriptorSet{};
         postImageDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        postImageDescriptorSet.dstSet = graphics.descriptorSetPostComputeFinal;
+        postImageDescriptorSet.dstSet = frame.descriptorSetPostComputeFinal;
         postImageDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         postImageDescriptorSet.dstBinding = 1;
-        postImageDescriptorSet.pImageInfo = &radianceTexture.descriptor;
+        postImageDescriptorSet.pImageInfo = &frame.radianceTexture.descriptor;
         postImageDescriptorSet.descriptorCount = 1;
 
         VkWriteDescriptorSet postComputeFragmentUniformDescriptorSet{};
         postComputeFragmentUniformDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        postComputeFragmentUniformDescriptorSet.dstSet = graphics.descriptorSetPostComputeFinal;
+        postComputeFragmentUniformDescriptorSet.dstSet = frame.descriptorSetPostComputeFinal;
         postComputeFragmentUniformDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         postComputeFragmentUniformDescriptorSet.dstBinding = 2;
-        postComputeFragmentUniformDescriptorSet.pBufferInfo = &uniformBufferFragmentShader->getBufferInfo();
+        postComputeFragmentUniformDescriptorSet.pBufferInfo = &frame.uniformBufferFragmentShader->getBufferInfo();
         postComputeFragmentUniformDescriptorSet.descriptorCount = 1;
 
         std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
@@ -1221,6 +1541,9 @@ void VulkanEngineEntryPoint::updateGraphicsDescriptorSets() {
 }
 
 void VulkanEngineEntryPoint::saveScreenshot(const char *filename) {
+    // Frames in flight have to finish before the swap-chain image is copied
+    vkDeviceWaitIdle(engineDevice.getDevice());
+
     bool supportsBlit = true;
 
     // Check blit support for source and destination
@@ -1410,33 +1733,23 @@ VulkanEngineEntryPoint::loadShader(const std::string &fileName, VkShaderStageFla
     return shaderStage;
 }
 
+// Shaders are compiled into the binary, so they don't depend on the working directory
 VkShaderModule VulkanEngineEntryPoint::loadShaderModule(const char *fileName, VkDevice device) {
-    std::ifstream is(fileName, std::ios::binary | std::ios::in | std::ios::ate);
-
-    if (is.is_open()) {
-        size_t size = is.tellg();
-        is.seekg(0, std::ios::beg);
-        char *shaderCode = new char[size];
-        is.read(shaderCode, std::streamsize(size));
-        is.close();
-
-        assert(size > 0);
-
-        VkShaderModule shaderModule;
-        VkShaderModuleCreateInfo moduleCreateInfo{};
-        moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        moduleCreateInfo.codeSize = size;
-        moduleCreateInfo.pCode = (uint32_t *) shaderCode;
+    const EmbeddedShader *shader = findEmbeddedShader(fileName);
+    if (shader == nullptr) {
+        std::cerr << "Error: Shader \"" << fileName << "\" is not embedded" << "\n";
+        return VK_NULL_HANDLE;
+    }
 
-        VK_CHECK(vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &shaderModule));
+    VkShaderModule shaderModule;
+    VkShaderModuleCreateInfo moduleCreateInfo{};
+    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleCreateInfo.codeSize = shader->size;
+    moduleCreateInfo.pCode = shader->code;
 
-        delete[] shaderCode;
+    VK_CHECK(vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &shaderModule));
 
-        return shaderModule;
-    } else {
-        std::cerr << "Error: Could not open shader file \"" << fileName << "\"" << "\n";
-        return VK_NULL_HANDLE;
-    }
+    return shaderModule;
 }
 
 void VulkanEngineEntryPoint::handleEvents() {
@@ -9,11 +9,15 @@
 #include "rendering/VulkanEngineDescriptors.h"
 #include "rendering/VulkanEngineBuffer.h"
 #include "rendering/VulkanTexture.h"
+#include "rendering/VulkanFrameAllocator.h"
+#include "rendering/VulkanEnginePipelineCache.h"
+#include "rendering/VulkanComputeGraph.h"
 #include "rendering/Camera.h"
 #include "rendering/VulkanTools.h"
 #include "GlobalConfiguration.h"
 #include "rendering/gui/DebugGui.h"
 #include "algorithms/DatasetFileReader.h"
+#include "threading/BS_thread_pool.h"
 
 #include "glm/glm.hpp"
 
@@ -50,37 +54,134 @@ public:
         glm::int32_t imageHeight;
         glm::float32_t omega;
         alignas(4) glm::float32_t epsilon;
+        alignas(4) glm::int32_t debugOutputs;
+        alignas(4) glm::int32_t filterRadius;
+        alignas(4) glm::int32_t filterPass; // Pass of the shaders recorded several times per frame
+        alignas(4) glm::int32_t guidedFilterRadius;
     } computePushConstant{};
 
     struct {
         VkDescriptorSetLayout descriptorSetLayout;
-        VkDescriptorSet descriptorSetPreCompute;
-        VkDescriptorSet descriptorSetPostComputeStageOne;
-        VkDescriptorSet descriptorSetPostComputeStageTwo;
-        VkDescriptorSet descriptorSetPostComputeStageThree;
-        VkDescriptorSet descriptorSetPostComputeStageFour;
-        VkDescriptorSet descriptorSetPostComputeFinal;
-
         VkPipeline pipeline;
         VkPipelineLayout pipelineLayout;
     } graphics{};
 
+    // Specialization constants of the compute shaders, chosen per device in prepareComputeSpecialization().
+    // Every shader declares only the ones it uses, local sizes take separate ids aliasing the same values.
+    struct ComputeSpecialization {
+        uint32_t groupSize; // constant_id 0, local_size_x_id 1 and local_size_y_id 2 of the per-pixel shaders
+        uint32_t lineGroupSize; // constant_id 3 and local_size_x_id 4 of the shaders filtering rows and columns
+        uint32_t reductionGroupSize; // constant_id 5 and local_size_x_id 6 of the airlight reduction
+        uint32_t candidatesPerThread; // constant_id 7, airlight candidates every reduction invocation reads
+        uint32_t maxFilterRadius; // constant_id 8, largest dark channel radius the minimum filter has room for
+        uint32_t transmissionRadius; // constant_id 9, fixed windows of the fused dehaze kernel
+        uint32_t guidedFilterRadius; // constant_id 10
+    };
+
     struct Compute {
         VkDescriptorSetLayout descriptorSetLayout;
-        VkDescriptorSet descriptorSet;
         VkPipelineLayout pipelineLayout;
         VkPipeline pipeline;
     };
 
-    explicit VulkanEngineEntryPoint(Dataset *dataset);
+    // Compute passes in the order their pipelines are created in prepareCompute(),
+    // indexes both compute and FrameResources::computeDescriptorSets
+    enum ComputePass : uint32_t {
+        DarkChannelPriorPass, // Airlight candidates of every workgroup from the filtered dark channel, or its histogram
+        MaximumAirLightPass,
+        GuidedFilterPass,
+        RadiancePass,
+        UnpackPass,
+        FusedDehazePass,
+        DarkChannelRowsPass,
+        DarkChannelColumnsPass,
+        TransmissionRowsPass,
+        TransmissionColumnsPass,
+    };
+
+    // Timestamps every frame in flight writes into its range of timestampQueryPool, each one ends the stage it names.
+    // The graphics stage is timed on its own queue, timestamps of different queues need not be comparable.
+    enum GpuTimestamp : uint32_t {
+        FrameStartTimestamp,
+        UnpackTimestamp, // Includes the upload of the camera frame without a dedicated transfer queue
+        DarkChannelTimestamp,
+        AirLightTimestamp,
+        TransmissionTimestamp, // Same as AirLightTimestamp with the fused dehaze
+        GuidedFilterTimestamp, // Same as AirLightTimestamp with the fused dehaze
+        RadianceTimestamp,
+        GraphicsStartTimestamp,
+        GraphicsTimestamp,
+        GpuTimestampCount,
+    };
+
+    // Everything the recorded compute passes depend on besides the resources of the frame
+    struct ComputeChainParameters {
+        glm::int32_t filterRadius;
+        glm::int32_t guidedFilterRadius;
+        glm::float32_t epsilon;
+        bool useFusedDehaze;
+        bool useTopDarkChannelAirLight;
+
+        bool operator==(const ComputeChainParameters &other) const {
+            return filterRadius == other.filterRadius && guidedFilterRadius == other.guidedFilterRadius &&
+                   epsilon == other.epsilon && useFusedDehaze == other.useFusedDehaze &&
+                   useTopDarkChannelAirLight == other.useTopDarkChannelAirLight;
+        }
+
+        bool operator!=(const ComputeChainParameters &other) const { return !(*this == other); }
+    };
+
+    // Everything a single frame in flight writes to. The GPU may still be working on the other frames,
+    // so a frame's resources are only touched again after the fence of its previous use has been waited on.
+    struct FrameResources {
+        std::unique_ptr<VulkanEngineBuffer> inputFrameBuffer; // Packed BGR camera frame, unpacked into inputTexture
+        cv::Mat uploadedFrame; // Decoded frame the GPU copies from, kept alive until the frame's fence is waited on
+        Texture2D inputTexture{};
+        // Intermediate maps of the debug views, transient images of the compute graph in the single view mode
+        Texture2D darkChannelPriorTexture{};
+        Texture2D transmissionTexture{};
+        Texture2D filteredTransmissionTexture{};
+        Texture2D radianceTexture{};
+
+        std::unique_ptr<VulkanEngineBuffer> uniformBufferVertexShader;
+        std::unique_ptr<VulkanEngineBuffer> uniformBufferFragmentShader;
+        std::unique_ptr<VulkanEngineBuffer> airLightGroupsBuffer;
+        std::unique_ptr<VulkanEngineBuffer> airLightPartialsBuffer;
+        std::unique_ptr<VulkanEngineBuffer> darkChannelHistogramBuffer;
+        std::unique_ptr<VulkanEngineBuffer> airLightMaxBuffer;
+
+        std::vector<VkDescriptorSet> computeDescriptorSets; // One for every compute pipeline, written by computeGraph
+
+        VkDescriptorSet descriptorSetPreCompute;
+        VkDescriptorSet descriptorSetPostComputeStageOne;
+        VkDescriptorSet descriptorSetPostComputeStageTwo;
+        VkDescriptorSet descriptorSetPostComputeStageThree;
+        VkDescriptorSet descriptorSetPostComputeStageFour;
+        VkDescriptorSet descriptorSetPostComputeFinal;
+
+        uint64_t inputImageVersion = 0; // Version of the camera frame currently uploaded into inputFrameBuffer
+        bool hasGpuTimestamps = false; // Its timestamp queries were submitted and can be read back
+
+        // Secondary command buffer with the compute passes, executed every frame and only re-recorded
+        // when its parameters change or the resources are recreated
+        VkCommandBuffer computeChainCommandBuffer = VK_NULL_HANDLE;
+        std::unique_ptr<VulkanComputeGraph> computeGraph; // Passes of the chain, rebuilt when their switches change
+        ComputeChainParameters computeChainParameters{};
+        bool isComputeChainRecorded = false;
+    };
+
+    // Pipelines are created on the pool, which is free again once the constructor returns
+    VulkanEngineEntryPoint(Dataset *dataset, BS::thread_pool &pool);
 
     ~VulkanEngineEntryPoint() {
-        inputTexture.destroy(engineDevice);
-        darkChannelPriorTexture.destroy(engineDevice);
-        transmissionTexture.destroy(engineDevice);
-        filteredTransmissionTexture.destroy(engineDevice);
-        radianceTexture.destroy(engineDevice);
+        vkDeviceWaitIdle(engineDevice.getDevice());
 
+        for (FrameResources &frame: frames) {
+            destroyFrameTextures(frame);
+            vkFreeCommandBuffers(engineDevice.getDevice(), engineDevice.getComputeCommandPool(), 1,
+                                 &frame.computeChainCommandBuffer);
+        }
+        destroyGuidedFilterScratch();
 
         for (VkShaderModule module: shaderModules) {
             vkDestroyShaderModule(engineDevice.getDevice(), module, nullptr);
@@ -97,17 +198,26 @@ public:
 
         vkDestroyDescriptorSetLayout(engineDevice.getDevice(), graphics.descriptorSetLayout, nullptr);
         vkDestroyDescriptorPool(engineDevice.getDevice(), descriptorPool, nullptr);
+        vkDestroyQueryPool(engineDevice.getDevice(), timestampQueryPool, nullptr);
     };
 
-    void prepareInputImage();
+    void prepareInputStagingRing();
+
+    void uploadInputImage(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+
+    void prepareGuidedFilterScratch();
+
+    void prepareFrameResources(FrameResources &frame);
+
+    void resizeInputResources();
 
     void generateQuad();
 
     void setupVertexDescriptions();
 
-    void prepareGraphicsUniformBuffers();
+    void prepareGraphicsUniformBuffers(FrameResources &frame);
 
-    void updateGraphicsUniformBuffers();
+    void updateGraphicsUniformBuffers(FrameResources &frame);
 
     void setupDescriptorSetLayout();
 
@@ -119,16 +229,26 @@ public:
 
     void prepareCompute();
 
-    void updateComputeDescriptorSets();
+    void prepareComputeSpecialization();
 
-    void updateGraphicsDescriptorSets();
+    void prepareGpuTimestamps();
+
+    void updateGraphicsDescriptorSets(FrameResources &frame);
 
     void render();
 
+    void benchmarkMinFilter();
+
     void prepareNextFrame();
 
     void handleEvents();
 
+    // Dataset which is shown by the following prepareNextFrame() and render() calls
+    void setDataset(Dataset *_dataset) { dataset = _dataset; }
+
+    // Camera frames allocated by it are uploaded without a staging copy, they must be released before the entry point
+    cv::MatAllocator *getFrameAllocator() { return &frameAllocator; }
+
     void saveScreenshot(const char *filename);
 
     bool isRunning = false; // If set to false, program will end
@@ -141,39 +261,93 @@ private:
 
     static VkShaderModule loadShaderModule(const char *fileName, VkDevice device);
 
+    void destroyFrameTextures(FrameResources &frame);
+
+    void destroyGuidedFilterScratch();
+
+    VkDeviceSize getInputFrameSize() const;
+
+    // Workgroups covering the input image with square tiles of the given size
+    VkExtent2D getTileGroupCount(uint32_t groupSize) const;
+
+    uint32_t getAirLightPartialCount() const;
+
+    // Ends a stage of the current frame, does nothing without timestamp support
+    void writeGpuTimestamp(VkCommandBuffer commandBuffer, GpuTimestamp timestamp, VkPipelineStageFlagBits stage);
+
+    // Stage times of the previous use of the current frame's queries into the dataset, never waits for the GPU
+    void readGpuTimestamps(FrameResources &frame);
+
+    // Pass of a compute pipeline bound with the frame's descriptor set of the pipeline
+    VulkanComputeGraph::Pass computePass(std::string name, FrameResources &frame, ComputePass pipeline,
+                                         std::vector<VulkanComputeGraph::Binding> bindings,
+                                         std::function<void(VkCommandBuffer)> record);
+
+    void pushComputeConstants(VkCommandBuffer commandBuffer, ComputePass pipeline, glm::int32_t filterPass);
+
+    // Workgroups of a shader filtering all rows or all columns of the input image with the given radius
+    void dispatchLines(VkCommandBuffer commandBuffer, bool isRowPass, glm::int32_t radius) const;
+
+    // Rows and the following columns pass of a separable minimum filter
+    void addMinFilterPasses(VulkanComputeGraph &graph, FrameResources &frame, ComputePass rowsPass,
+                            VulkanComputeGraph::Resource input, VulkanComputeGraph::Resource rowMinimums,
+                            VulkanComputeGraph::Resource output, VulkanComputeGraph::Resource airLightMax);
+
+    // All compute passes from the unpacked input to the radiance, which is visible to the graphics pass
+    std::unique_ptr<VulkanComputeGraph> buildComputeGraph(FrameResources &frame,
+                                                          const ComputeChainParameters &parameters);
+
+    // Re-records the compute chain of the frame if it was recorded with different parameters or resources
+    void updateComputeChain(FrameResources &frame);
+
     void
-    prepareComputePipeline(std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings, const std::string &shaderName);
+    prepareComputePipeline(std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings, const std::string &shaderName,
+                           const ComputeSpecialization &specialization);
 
     VulkanEngineWindow window{WINDOW_TITLE, WINDOW_WIDTH, WINDOW_HEIGHT,
                               SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE};
     VulkanEngineDevice engineDevice{window, WINDOW_TITLE};
     VulkanEngineRenderer renderer{window, engineDevice};
+    VulkanEnginePipelineCache pipelineCache{engineDevice};
     Camera camera{};
 
 #if DEBUG_GUI_ENABLED
-    DebugGui debugGui{engineDevice, renderer, window.sdlWindow()};
+    DebugGui debugGui{engineDevice, renderer, window.sdlWindow(), pipelineCache.getPipelineCache()};
 #endif
 
-    Texture2D inputTexture{};
-    Texture2D darkChannelPriorTexture{};
-    Texture2D transmissionTexture{};
-    Texture2D filteredTransmissionTexture{};
-    Texture2D radianceTexture{};
+    VulkanFrameAllocator frameAllocator{engineDevice};
+
+    std::array<FrameResources, VulkanEngineSwapChain::MAX_FRAMES_IN_FLIGHT> frames;
+
+    // Camera frame of the dataset, every frame in flight uploads it once it has a new version
+    uint64_t inputImageVersion = 0;
+
+    // Persistently mapped staging memory with a region for every frame in flight
+    std::unique_ptr<VulkanEngineBuffer> inputStagingRing;
+
+    // Box filtered statistics and linear coefficients of the guided filter, shared by all frames in flight
+    std::array<Texture2D, 4> guidedFilterStatistics{};
+    Texture2D guidedFilterCoefficients{};
+
+    // Input frame is copied on the dedicated transfer queue and handed over to the compute queue family
+    bool isTransferQueueUsed = false;
+    QueueFamilyIndices queueFamilyIndices{};
 
     std::unique_ptr<VulkanEngineBuffer> vertexBuffer;
     std::unique_ptr<VulkanEngineBuffer> indexBuffer;
 
-    std::unique_ptr<VulkanEngineBuffer> uniformBufferVertexShader;
-    std::unique_ptr<VulkanEngineBuffer> uniformBufferFragmentShader;
-    std::unique_ptr<VulkanEngineBuffer> airLightGroupsBuffer;
-    std::unique_ptr<VulkanEngineBuffer> airLightMaxBuffer;
-
     std::vector<VkShaderModule> shaderModules;
 
     std::vector<Compute> compute;
+    std::vector<std::future<VkPipeline>> pendingComputePipelines; // Indexed like compute, until prepareCompute() ends
+    ComputeSpecialization computeSpecialization{};
+    ComputeSpecialization fusedDehazeSpecialization{}; // Smaller tiles, its shared memory grows with their halo
 
     VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
 
+    VkQueryPool timestampQueryPool = VK_NULL_HANDLE; // GpuTimestampCount queries for every frame in flight
+    uint64_t timestampMask = 0; // Valid bits of the timestamps, they wrap around past them
+
     uint32_t indexCount{};
 
     glm::vec2 mouseDragOrigin{};
@@ -182,6 +356,8 @@ private:
 
     // DatasetFileReader
     Dataset *dataset;
+
+    BS::thread_pool &pool;
 };
 
 
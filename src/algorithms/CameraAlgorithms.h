@@ -0,0 +1,57 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "../GlobalConfiguration.h"
+#include "../util/Dataset.h"
+#include "../profiling/Timer.h"
+#include "../threading/BS_thread_pool.h"
+
+#include "DatasetFileReader.h"
+#include "VisibilityCalculation.h"
+#include "GlareAndOcclusionDetection.h"
+#include "VanishingPointEstimation.h"
+#include "GeometryAssertion.h"
+
+inline void runCameraAlgorithms(Dataset *dataset, BS::thread_pool &pool) {
+    if (dataset != nullptr && dataset->frameIndex != 0) {
+        Timer tim("All CPU algorithms", &dataset->allCPUAlgorithms);
+
+        cv::Mat leftCameraFrameGray;
+        cv::Mat rightCameraFrameGray;
+        cv::cvtColor(dataset->leftCameraFrame, leftCameraFrameGray, cv::COLOR_BGR2GRAY);
+        cv::cvtColor(dataset->rightCameraFrame, rightCameraFrameGray, cv::COLOR_BGR2GRAY);
+
+        estimateVanishingPointPosition(dataset);
+
+        // Algorithms run in parallel pool
+        pool.push_task(VisibilityCalculation::calculateVisibilityVp, leftCameraFrameGray, dataset,
+                       dataset->vanishingPoint);
+        pool.push_task(detectGlareAndOcclusion, leftCameraFrameGray, dataset);
+
+        {
+            Timer t("Fog detection", &dataset->fogDetection);
+            for (int j = 0; j < DFT_BLOCK_COUNT; j++) {
+                for (int i = 0; i < DFT_BLOCK_COUNT; i++) {
+                    int w = (DFT_WINDOW_SIZE / 2) +
+                            (i * ((dataset->cameraWidth - DFT_WINDOW_SIZE) / (DFT_BLOCK_COUNT - 1)));
+                    int h = (DFT_WINDOW_SIZE / 2) +
+                            (j * ((dataset->cameraHeight - DFT_WINDOW_SIZE) / (DFT_BLOCK_COUNT - 1)));
+
+                    pool.push_task(VisibilityCalculation::calculateVisibility, leftCameraFrameGray, dataset,
+                                   std::pair(w, h),
+                                   std::pair(i, j));
+                }
+            }
+            pool.wait_for_tasks();
+        }
+
+        {
+            Timer timer("Assert camera geometry");
+            assertCameraGeometry(dataset, leftCameraFrameGray, rightCameraFrameGray, pool);
+        }
+
+        VisibilityCalculation::calculateVisibilityScore(dataset);
+    }
+}
@@ -9,204 +9,588 @@
 #include "../../external/fastcsv/csv.h"
 #include "../../external/sunset/sunset.h"
 #include <fmt/core.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <tuple>
 #include "opencv4/opencv2/opencv.hpp"
 #include "../util/circularbuffer.h"
 #include "../util/Dataset.h"
 #include "../profiling/Timer.h"
 
 #include "../threading/BS_thread_pool.h"
+#include "../threading/FramePrefetcher.h"
+#include "FrameSynchronizer.h"
+#include "../util/SensorLogCache.h"
+#include "../util/FrameMetadataTable.h"
 
 class DatasetFileReader {
 public:
-    DatasetFileReader(Dataset *_dataset, BS::thread_pool &pool) : dataset(_dataset) {
-        io::CSVReader<3> in_camera_timestamps(std::string(SESSION_PATH) + std::string(CAMERA_TIMESTAMPS_PATH));
-        long _timestamp, _frame_index, _camera_timestamp;
-        while (in_camera_timestamps.read_row(_timestamp, _frame_index, _camera_timestamp)) {
-            timestamps.emplace_back(_timestamp);
+    // Only a reader which goes through the whole session from its start may spill the history, the files are shared
+    // by every reader of the session and their values are indexed by the frame index
+    DatasetFileReader(Dataset *_dataset, BS::thread_pool &pool, uint32_t startFrame = 0,
+                      std::string _sessionPath = SESSION_PATH, bool _isSpillEnabled = TIMESERIES_SPILL_ENABLED)
+            : dataset(_dataset), sessionPath(std::move(_sessionPath)), framePrefetcher(sessionPath),
+              isSpillEnabled(_isSpillEnabled && startFrame == 0) {
+        loadSensorLogs(pool);
+        loadKeyframeIndices(pool);
+
+        // Right camera is matched by its own timestamps only if the session recorded them
+        if (!right_timestamps.empty()) {
+            framePrefetcher.setStreamSync(FramePrefetcher::Right, FrameSynchronizer::match(timestamps, right_timestamps));
         }
+        framePrefetcher.setStreamSync(FramePrefetcher::Thermal, FrameSynchronizer::match(timestamps, thermal_timestamps));
 
-        io::CSVReader<4> in_thermal_timestamps(std::string(SESSION_PATH) + std::string(THERMAL_TIMESTAMPS_PATH));
-        double _min_temp, _max_temp;
-        while (in_thermal_timestamps.read_row(_timestamp, _frame_index, _min_temp, _max_temp)) {
-            thermal_timestamps.emplace_back(_timestamp);
-            min_temp.emplace_back(_min_temp);
-            max_temp.emplace_back(_max_temp);
+        buildFrameMetadata(pool);
+
+        for (int i = 0; i < HISTOGRAM_COUNT * HISTOGRAM_COUNT; i++) {
+            dataset->occlusionBuffers.emplace_back(OCCLUSION_MIN_FRAMES);
         }
 
-        io::CSVReader<11> in_imu(std::string(SESSION_PATH) + std::string(IMU_PATH));
-        float _acc_x, _acc_y, _acc_z, _ang_vel_x, _ang_vel_y, _ang_vel_z, _quat_x, _quat_y, _quat_z, _quat_w;
-        while (in_imu.read_row(_timestamp, _acc_x, _acc_y, _acc_z, _ang_vel_x, _ang_vel_y, _ang_vel_z, _quat_x, _quat_y,
-                               _quat_z, _quat_w)) {
-            imu_timestamps.emplace_back(_timestamp);
+        if (isSpillEnabled) {
+            dataset->heading.enableSpill(sessionPath + "history_heading.bin");
+            dataset->headingDif.enableSpill(sessionPath + "history_heading_dif.bin");
+            dataset->attitude.enableSpill(sessionPath + "history_attitude.bin");
+            dataset->attitudeDif.enableSpill(sessionPath + "history_attitude_dif.bin");
+            dataset->vp_visibility.enableSpill(sessionPath + "history_vp_visibility.bin");
+        }
 
-            acc_x.emplace_back(_acc_x);
-            acc_y.emplace_back(_acc_y);
-            acc_z.emplace_back(_acc_z);
+        dataset->totalFrames = framePrefetcher.getTotalFrames();
+        if (startFrame >= dataset->totalFrames) {
+            throw std::out_of_range(fmt::format("Start frame {} is past the end of the session with {} frames",
+                                                startFrame, dataset->totalFrames));
+        }
+        dataset->frameIndex = startFrame;
+        framePrefetcher.seek(startFrame);
+        readData(pool);
+    }
+
+    // Jumps to any frame of the session, the frame and its sensor data are read into the dataset
+    bool seek(uint32_t frameIndex, BS::thread_pool &pool) {
+        if (!seekStreams(frameIndex)) return false;
 
-            ang_vel_x.emplace_back(_ang_vel_x);
-            ang_vel_y.emplace_back(_ang_vel_y);
-            ang_vel_z.emplace_back(_ang_vel_z);
+        dataset->frameIndex = frameIndex;
+        return readData(pool);
+    }
 
-            quat_x.emplace_back(_quat_x);
-            quat_y.emplace_back(_quat_y);
-            quat_z.emplace_back(_quat_z);
-            quat_w.emplace_back(_quat_w);
+    // Only repositions the video decoders, the next readFrame() returns the given frame
+    bool seekStreams(uint32_t frameIndex) {
+        if (frameIndex >= framePrefetcher.getTotalFrames()) return false;
+
+        // The history continues from another frame, so the spilled values would no longer match the frame indices
+        if (isSpillEnabled) {
+            fmt::print("Seeking stops the history spill at frame {}\n", dataset->frameIndex);
+            for (auto *series: {&dataset->heading, &dataset->headingDif, &dataset->attitude, &dataset->attitudeDif,
+                                &dataset->vp_visibility}) {
+                series->disableSpill();
+            }
+            isSpillEnabled = false;
         }
 
-        io::CSVReader<8> in_time(std::string(SESSION_PATH) + std::string(TIME_PATH));
-        float _year, _month, _day, _hours, _minutes, _seconds, _nanoseconds;
-        while (in_time.read_row(_timestamp, _year, _month, _day, _hours, _minutes, _seconds, _nanoseconds)) {
-            imu_gnss_timestamps.emplace_back(_timestamp);
+        framePrefetcher.seek(frameIndex);
+        return true;
+    }
 
-            year.emplace_back(_year);
-            month.emplace_back(_month);
-            day.emplace_back(_day);
+    bool readData(BS::thread_pool &pool) {
+        long i = dataset->frameIndex;
+        if (i >= long(frameMetadata.size())) return false;
 
-            hours.emplace_back(_hours);
-            minutes.emplace_back(_minutes);
-            seconds.emplace_back(_seconds);
-            nanoseconds.emplace_back(_nanoseconds);
-        }
+        bool isOk = readFrame(dataset);
+        appendHistory(dataset);
+
+        return i <= 0 || isOk;
+    }
+
+    // Reads the frame given by target->frameIndex and its sensor data, the history series are left untouched.
+    // Frames must be read in order, so only one thread may call this at a time.
+    bool readFrame(Dataset *target) {
+        long i = target->frameIndex;
+        if (i >= long(frameMetadata.size())) return false;
+
+        target->year = frameMetadata.year[i];
+        target->month = frameMetadata.month[i];
+        target->day = frameMetadata.day[i];
+
+        target->hours = frameMetadata.hours[i];
+        target->minutes = frameMetadata.minutes[i];
+        target->seconds = frameMetadata.seconds[i];
+
+        target->latitude = frameMetadata.latitude[i];
+        target->longitude = frameMetadata.longitude[i];
+        target->altitude = frameMetadata.altitude[i];
+        target->azimuth = frameMetadata.azimuth[i];
 
-        io::CSVReader<5> in_pose(std::string(SESSION_PATH) + std::string(POSE_PATH));
-        float _latitude, _longitude, _altitude, _azimuth;
-        while (in_pose.read_row(_timestamp, _latitude, _longitude, _altitude, _azimuth)) {
-            gnss_timestamps.emplace_back(_timestamp);
+        target->sunrise = frameMetadata.sunrise[i];
+        target->sunset = frameMetadata.sunset[i];
+        target->isDaylight = frameMetadata.isDaylight[i];
 
-            latitude.emplace_back(_latitude);
-            longitude.emplace_back(_longitude);
-            altitude.emplace_back(_altitude);
-            azimuth.emplace_back(_azimuth);
+        return readCameraFrame(target);
+    }
+
+    // Appends heading and attitude of target->frameIndex to the history series of the target
+    void appendHistory(Dataset *target) const {
+        long i = target->frameIndex;
+        if (i >= long(frameMetadata.size())) return;
+
+        target->heading.emplace_back(frameMetadata.heading[i]);
+        target->attitude.emplace_back(frameMetadata.attitude[i]);
+
+        // Save inferred variables
+        if (i <= 0) return;
+
+        target->headingDif.emplace_back(frameMetadata.headingDif[i]);
+        target->attitudeDif.emplace_back(frameMetadata.attitudeDif[i]);
+    }
+
+    // Left camera frames are decoded straight into memory of the allocator
+    void setFrameAllocator(cv::MatAllocator *allocator) {
+        framePrefetcher.setFrameAllocator(FramePrefetcher::Left, allocator);
+    }
+
+    bool readCameraFrame(Dataset *target) {
+        if (target->frameIndex < framePrefetcher.getTotalFrames()) {
+            Timer timer("Camera frame extraction", &target->cameraFrameExtraction);
+
+            // Frames are decoded ahead by the prefetcher, this only waits if it couldn't keep up
+            return framePrefetcher.pop(target);
         }
+        return false;
+    }
 
-        for (int i = 0; i < HISTOGRAM_COUNT * HISTOGRAM_COUNT; i++) {
-            dataset->occlusionBuffers.emplace_back(OCCLUSION_MIN_FRAMES);
+private:
+    struct IngestStats {
+        std::string file;
+        size_t rows = 0;
+        float time = 0.0f;
+
+        IngestStats(const char *_file) : file(_file) {}
+    };
+
+    // Times the ingestion of one file regardless of TIMER_ON, the breakdown is printed either way
+    struct IngestTimer {
+        IngestStats &stats;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        explicit IngestTimer(IngestStats &_stats) : stats(_stats) {}
+
+        ~IngestTimer() {
+            stats.time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
         }
+    };
 
-        readData(pool);
+    // Keyframe indices of all videos are loaded from their cache or built in parallel
+    void loadKeyframeIndices(BS::thread_pool &pool) {
+        Timer timer("Keyframe index loading");
+
+        std::vector<std::future<KeyframeIndex>> indices;
+        for (int stream = 0; stream < FramePrefetcher::StreamCount; stream++) {
+            const std::string &videoPath = framePrefetcher.getVideoPath(FramePrefetcher::Stream(stream));
+            indices.emplace_back(pool.submit(KeyframeIndex::loadOrBuild, videoPath));
+        }
+        for (int stream = 0; stream < FramePrefetcher::StreamCount; stream++) {
+            framePrefetcher.setKeyframeIndex(FramePrefetcher::Stream(stream), indices[stream].get());
+        }
     }
 
-    bool readData(BS::thread_pool &pool) {
-        long i = dataset->frameIndex;
-        bool isOk;
-
-        // Find IMU positions that corresponds to the actual camera frame timestamp
-        do {
-            imu_index += 1;
-            previousTimeDif = abs(timestamps[i] - imu_timestamps[imu_index]);
-        } while (abs(timestamps[i] - imu_timestamps[imu_index + 1]) < previousTimeDif);
-
-        // Find GNSS positions that corresponds to the actual camera frame timestamp
-        previousTimeDif = INT_MAX;
-        do {
-            gnss_index += 1;
-            previousTimeDif = abs(timestamps[i] - gnss_timestamps[gnss_index]);
-        } while (abs(timestamps[i] - gnss_timestamps[gnss_index + 1]) < previousTimeDif);
-
-        dataset->year = int(year[gnss_index]);
-        dataset->month = int(month[gnss_index]);
-        dataset->day = int(day[gnss_index]);
-
-        dataset->hours = int(hours[gnss_index] + TIMEZONE_OFFSET);
-        dataset->minutes = int(minutes[gnss_index]);
-        dataset->seconds = int(seconds[gnss_index]);
-
-        // Daylight savings time
-        double dst = 0.0;
-        if (dataset->month > 3 && dataset->month < 10) dst = 1.0;
-        if (dataset->month == 3 && dataset->day >= 26 && dataset->hours >= 2) dst = 1.0;
-        if (dataset->month == 10 && dataset->day <= 29 && dataset->hours <= 3) dst = 1.0;
-        dataset->hours += int(dst);
-
-        dataset->latitude = latitude[gnss_index];
-        dataset->longitude = longitude[gnss_index];
-        dataset->altitude = altitude[gnss_index];
-        dataset->azimuth = azimuth[gnss_index];
-
-        // Calculate heading and attitude
-        glm::quat q = glm::quat(float(quat_w[imu_index]), float(quat_x[imu_index]), float(quat_y[imu_index]),
-                                float(quat_z[imu_index]));
-        glm::vec3 euler = glm::eulerAngles(q);
-        dataset->heading.emplace_back(((euler[2] + M_PI) * 180) / M_PI);
-        dataset->attitude.emplace_back(euler[1]);
-
-        // Calculate sun position and sunrise/sunset
-        sunCalc.setCurrentDate(dataset->year, dataset->month, dataset->day);
-        sunCalc.setPosition(dataset->latitude, dataset->longitude, TIMEZONE_OFFSET + dst);
-        dataset->sunrise = sunCalc.calcSunrise() / 60.0;
-        dataset->sunset = sunCalc.calcSunset() / 60.0;
-        double h = dataset->hours + (dataset->minutes / 60.0);
-        dataset->isDaylight = h < dataset->sunset && h > dataset->sunrise;
-
-        isOk = readCameraFrame(pool);
+    // Aligns IMU and GNSS samples to every camera frame and precomputes everything derived from them,
+    // so reading a frame is only a lookup into the table
+    void buildFrameMetadata(BS::thread_pool &pool) {
+        Timer timer("Frame metadata table");
+
+        size_t frameCount = timestamps.size();
+
+        // Every frame is aligned to a sample of these logs, a log with only its header has nothing to align to
+        if (frameCount > 0) {
+            for (const auto &[name, column]: {std::make_pair(IMU_PATH, imu_timestamps),
+                                              std::make_pair(TIME_PATH, imu_gnss_timestamps),
+                                              std::make_pair(POSE_PATH, gnss_timestamps)}) {
+                if (column.size() == 0) {
+                    throw std::runtime_error("Sensor log " + sessionPath + name + " has no samples");
+                }
+            }
+        }
+        frameMetadata.resize(frameCount);
+
+        pool.parallelize_loop(size_t(0), frameCount, [this](size_t start, size_t end) {
+            for (size_t i = start; i < end; i++) {
+                uint32_t imu = nearestSample(imu_timestamps, timestamps[i]);
+                uint32_t gnss = nearestSample(gnss_timestamps, timestamps[i]);
+                uint32_t time = nearestSample(imu_gnss_timestamps, timestamps[i]);
+                frameMetadata.imuIndex[i] = imu;
+                frameMetadata.gnssIndex[i] = gnss;
+
+                int month_ = int(month[time]);
+                int day_ = int(day[time]);
+                int hours_ = int(hours[time] + TIMEZONE_OFFSET);
+
+                // Daylight savings time
+                double dst = 0.0;
+                if (month_ > 3 && month_ < 10) dst = 1.0;
+                if (month_ == 3 && day_ >= 26 && hours_ >= 2) dst = 1.0;
+                if (month_ == 10 && day_ <= 29 && hours_ <= 3) dst = 1.0;
+
+                frameMetadata.year[i] = int(year[time]);
+                frameMetadata.month[i] = month_;
+                frameMetadata.day[i] = day_;
+                frameMetadata.hours[i] = hours_ + int(dst);
+                frameMetadata.minutes[i] = int(minutes[time]);
+                frameMetadata.seconds[i] = int(seconds[time]);
+                frameMetadata.dst[i] = dst;
+
+                frameMetadata.latitude[i] = latitude[gnss];
+                frameMetadata.longitude[i] = longitude[gnss];
+                frameMetadata.altitude[i] = altitude[gnss];
+                frameMetadata.azimuth[i] = azimuth[gnss];
+
+                // Calculate heading and attitude
+                glm::quat q = glm::quat(float(quat_w[imu]), float(quat_x[imu]), float(quat_y[imu]), float(quat_z[imu]));
+                glm::vec3 euler = glm::eulerAngles(q);
+                frameMetadata.heading[i] = ((euler[2] + M_PI) * 180) / M_PI;
+                frameMetadata.attitude[i] = euler[1];
+            }
+        }).wait();
+
+        // Sunrise and sunset only change with date and location, so they are calculated once per distinct day and place
+        std::map<std::tuple<int, int, int, long, long, int>, std::pair<double, double>> sunTimes;
+        for (size_t i = 0; i < frameCount; i++) {
+            auto key = std::make_tuple(frameMetadata.year[i], frameMetadata.month[i], frameMetadata.day[i],
+                                       std::lround(frameMetadata.latitude[i] * 100),
+                                       std::lround(frameMetadata.longitude[i] * 100), int(frameMetadata.dst[i]));
+            auto sunTime = sunTimes.find(key);
+            if (sunTime == sunTimes.end()) {
+                sunCalc.setCurrentDate(frameMetadata.year[i], frameMetadata.month[i], frameMetadata.day[i]);
+                sunCalc.setPosition(frameMetadata.latitude[i], frameMetadata.longitude[i],
+                                    TIMEZONE_OFFSET + frameMetadata.dst[i]);
+                sunTime = sunTimes.emplace(key, std::make_pair(sunCalc.calcSunrise() / 60.0,
+                                                               sunCalc.calcSunset() / 60.0)).first;
+            }
+            frameMetadata.sunrise[i] = sunTime->second.first;
+            frameMetadata.sunset[i] = sunTime->second.second;
 
-        // Save inferred variables
-        if (i <= 0) return true;
+            double h = frameMetadata.hours[i] + (frameMetadata.minutes[i] / 60.0);
+            frameMetadata.isDaylight[i] = h < frameMetadata.sunset[i] && h > frameMetadata.sunrise[i];
+
+            if (i == 0) continue;
 
-        dataset->headingDif.emplace_back(dataset->heading[i - 1] - dataset->heading[i]);
-        if (abs(dataset->headingDif.back()) > MAX_HEADING_DIF) {
-            dataset->headingDif.back() = 0;
+            frameMetadata.headingDif[i] = frameMetadata.heading[i - 1] - frameMetadata.heading[i];
+            if (abs(frameMetadata.headingDif[i]) > MAX_HEADING_DIF) {
+                frameMetadata.headingDif[i] = 0;
+            }
+            frameMetadata.attitudeDif[i] = frameMetadata.attitude[i - 1] - frameMetadata.attitude[i];
+            if (abs(frameMetadata.attitudeDif[i]) > MAX_ATTITUDE_DIF) {
+                frameMetadata.attitudeDif[i] = 0;
+            }
         }
-        dataset->attitudeDif.emplace_back(dataset->attitude[i - 1] - dataset->attitude[i]);
-        if (abs(dataset->attitudeDif[i]) > MAX_ATTITUDE_DIF) {
-            dataset->attitudeDif.back() = 0;
+    }
+
+    // Index of the sample with the closest timestamp, the samples must not be empty
+    static uint32_t nearestSample(ColumnSpan<long> sampleTimestamps, long timestamp) {
+        auto next = std::lower_bound(sampleTimestamps.begin(), sampleTimestamps.end(), timestamp);
+        if (next == sampleTimestamps.end()) return uint32_t(sampleTimestamps.size() - 1);
+        if (next == sampleTimestamps.begin()) return 0;
+
+        auto previous = next - 1;
+        if (timestamp - *previous <= *next - timestamp) return uint32_t(previous - sampleTimestamps.begin());
+        return uint32_t(next - sampleTimestamps.begin());
+    }
+
+    // Sensor logs are parsed from CSV only once, every following run just maps the binary cache
+    void loadSensorLogs(BS::thread_pool &pool) {
+        Timer timer("Sensor log loading");
+
+        std::string cachePath = sessionPath + std::string(SENSOR_CACHE_PATH);
+        uint64_t stamp = SensorLogCache::sourceStamp(sensorLogPaths(sessionPath));
+
+        if (!sensorLogCache.open(cachePath, stamp)) {
+            fmt::print("Converting sensor logs into {}\n", cachePath);
+            if (!convertSensorLogs(sessionPath, cachePath, stamp, pool) || !sensorLogCache.open(cachePath, stamp)) {
+                throw std::runtime_error("Failed to create sensor log cache " + cachePath);
+            }
         }
 
-        return isOk;
+        timestamps = sensorLogCache.integerColumn("timestamps");
+        right_timestamps = sensorLogCache.integerColumn("right_timestamps");
+        thermal_timestamps = sensorLogCache.integerColumn("thermal_timestamps");
+        imu_timestamps = sensorLogCache.integerColumn("imu_timestamps");
+        imu_gnss_timestamps = sensorLogCache.integerColumn("imu_gnss_timestamps");
+        gnss_timestamps = sensorLogCache.integerColumn("gnss_timestamps");
+
+        acc_x = sensorLogCache.realColumn("acc_x");
+        acc_y = sensorLogCache.realColumn("acc_y");
+        acc_z = sensorLogCache.realColumn("acc_z");
+        ang_vel_x = sensorLogCache.realColumn("ang_vel_x");
+        ang_vel_y = sensorLogCache.realColumn("ang_vel_y");
+        ang_vel_z = sensorLogCache.realColumn("ang_vel_z");
+        quat_x = sensorLogCache.realColumn("quat_x");
+        quat_y = sensorLogCache.realColumn("quat_y");
+        quat_z = sensorLogCache.realColumn("quat_z");
+        quat_w = sensorLogCache.realColumn("quat_w");
+
+        year = sensorLogCache.realColumn("year");
+        month = sensorLogCache.realColumn("month");
+        day = sensorLogCache.realColumn("day");
+        hours = sensorLogCache.realColumn("hours");
+        minutes = sensorLogCache.realColumn("minutes");
+        seconds = sensorLogCache.realColumn("seconds");
+        nanoseconds = sensorLogCache.realColumn("nanoseconds");
+
+        latitude = sensorLogCache.realColumn("latitude");
+        longitude = sensorLogCache.realColumn("longitude");
+        altitude = sensorLogCache.realColumn("altitude");
+        azimuth = sensorLogCache.realColumn("azimuth");
+
+        min_temp = sensorLogCache.realColumn("min_temp");
+        max_temp = sensorLogCache.realColumn("max_temp");
     }
 
-    bool readCameraFrame(BS::thread_pool &pool) {
-        std::uint32_t &i = dataset->frameIndex;
-        std::uint32_t &t_i = dataset->thermalFrameIndex;
+    // Rough row count from the file size and the average length of the first lines, only used to reserve memory
+    static size_t estimateRowCount(const std::string &path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) return 0;
 
-        if (i < totalFrames) {
-            Timer timer("Camera frame extraction", &dataset->cameraFrameExtraction);
+        auto fileSize = size_t(file.tellg());
+        file.seekg(0);
 
-            // Doesn't update the variable for some reason
-            //pool.push_task(&cv::VideoCapture::set, &thermalVideo, cv::CAP_PROP_POS_FRAMES, i * 3);
-            //pool.push_task(&cv::VideoCapture::read, &leftVideo, dataset->leftCameraFrame);
-            //pool.push_task(&cv::VideoCapture::read, &rightVideo, dataset->rightCameraFrame);
-            //while (pool.get_tasks_running() > 0);
+        std::string line;
+        size_t sampledBytes = 0, sampledLines = 0;
+        while (sampledLines < 64 && std::getline(file, line)) {
+            sampledBytes += line.size() + 1;
+            sampledLines++;
+        }
+        if (sampledLines == 0) return 0;
+
+        // Some headroom, later lines can be shorter than the sampled ones
+        return fileSize / (sampledBytes / sampledLines) * 11 / 10 + 1;
+    }
 
-            // This is actually quicker than advancing to specific frame via CAP_PROP_POS_FRAMES
-            // It is done because the thermal camera has 3x the framerate of RGB camera
-            for (int k = 0; k < 3; k++) {
-                thermalVideo.read(dataset->thermalCameraFrame);
+    static std::vector<std::string> sensorLogPaths(const std::string &sessionPath) {
+        return {sessionPath + std::string(CAMERA_TIMESTAMPS_PATH),
+                sessionPath + std::string(RIGHT_CAMERA_TIMESTAMPS_PATH),
+                sessionPath + std::string(THERMAL_TIMESTAMPS_PATH),
+                sessionPath + std::string(IMU_PATH),
+                sessionPath + std::string(TIME_PATH),
+                sessionPath + std::string(POSE_PATH)};
+    }
+
+    // Every log file is parsed by its own pool task, vectors are reserved up front from the estimated row count
+    static bool convertSensorLogs(const std::string &sessionPath, const std::string &cachePath, uint64_t stamp,
+                                  BS::thread_pool &pool) {
+        std::vector<long> timestamps, right_timestamps, thermal_timestamps, imu_timestamps, imu_gnss_timestamps, gnss_timestamps;
+        std::vector<double> acc_x, acc_y, acc_z, ang_vel_x, ang_vel_y, ang_vel_z, quat_x, quat_y, quat_z, quat_w;
+        std::vector<double> year, month, day, hours, minutes, seconds, nanoseconds;
+        std::vector<double> latitude, longitude, altitude, azimuth;
+        std::vector<double> min_temp, max_temp;
+
+        std::vector<IngestStats> ingestStats = {{CAMERA_TIMESTAMPS_PATH},
+                                                {RIGHT_CAMERA_TIMESTAMPS_PATH},
+                                                {THERMAL_TIMESTAMPS_PATH},
+                                                {IMU_PATH},
+                                                {TIME_PATH},
+                                                {POSE_PATH}};
+
+        std::vector<std::future<void>> tasks;
+        tasks.emplace_back(pool.submit([&, &stats = ingestStats[0]] {
+            IngestTimer timer(stats);
+            std::string path = sessionPath + stats.file;
+            timestamps.reserve(estimateRowCount(path));
+
+            io::CSVReader<3> in_camera_timestamps(path);
+            long _timestamp, _frame_index, _camera_timestamp;
+            while (in_camera_timestamps.read_row(_timestamp, _frame_index, _camera_timestamp)) {
+                timestamps.emplace_back(_timestamp);
+            }
+            stats.rows = timestamps.size();
+        }));
+
+        // Right camera timestamps are optional, an empty column is stored when the session didn't record them
+        tasks.emplace_back(pool.submit([&, &stats = ingestStats[1]] {
+            IngestTimer timer(stats);
+            std::string path = sessionPath + stats.file;
+            if (!std::ifstream(path).good()) return;
+            right_timestamps.reserve(estimateRowCount(path));
+
+            io::CSVReader<3> in_right_timestamps(path);
+            long _timestamp, _frame_index, _camera_timestamp;
+            while (in_right_timestamps.read_row(_timestamp, _frame_index, _camera_timestamp)) {
+                right_timestamps.emplace_back(_timestamp);
+            }
+            stats.rows = right_timestamps.size();
+        }));
+
+        tasks.emplace_back(pool.submit([&, &stats = ingestStats[2]] {
+            IngestTimer timer(stats);
+            std::string path = sessionPath + stats.file;
+            size_t rowCount = estimateRowCount(path);
+            thermal_timestamps.reserve(rowCount);
+            min_temp.reserve(rowCount);
+            max_temp.reserve(rowCount);
+
+            io::CSVReader<4> in_thermal_timestamps(path);
+            long _timestamp, _frame_index;
+            double _min_temp, _max_temp;
+            while (in_thermal_timestamps.read_row(_timestamp, _frame_index, _min_temp, _max_temp)) {
+                thermal_timestamps.emplace_back(_timestamp);
+                min_temp.emplace_back(_min_temp);
+                max_temp.emplace_back(_max_temp);
+            }
+            stats.rows = thermal_timestamps.size();
+        }));
+
+        tasks.emplace_back(pool.submit([&, &stats = ingestStats[3]] {
+            IngestTimer timer(stats);
+            std::string path = sessionPath + stats.file;
+            size_t rowCount = estimateRowCount(path);
+            for (auto *column: {&acc_x, &acc_y, &acc_z, &ang_vel_x, &ang_vel_y, &ang_vel_z, &quat_x, &quat_y, &quat_z,
+                                &quat_w}) {
+                column->reserve(rowCount);
+            }
+            imu_timestamps.reserve(rowCount);
+
+            io::CSVReader<11> in_imu(path);
+            long _timestamp;
+            float _acc_x, _acc_y, _acc_z, _ang_vel_x, _ang_vel_y, _ang_vel_z, _quat_x, _quat_y, _quat_z, _quat_w;
+            while (in_imu.read_row(_timestamp, _acc_x, _acc_y, _acc_z, _ang_vel_x, _ang_vel_y, _ang_vel_z, _quat_x,
+                                   _quat_y, _quat_z, _quat_w)) {
+                imu_timestamps.emplace_back(_timestamp);
+
+                acc_x.emplace_back(_acc_x);
+                acc_y.emplace_back(_acc_y);
+                acc_z.emplace_back(_acc_z);
+
+                ang_vel_x.emplace_back(_ang_vel_x);
+                ang_vel_y.emplace_back(_ang_vel_y);
+                ang_vel_z.emplace_back(_ang_vel_z);
+
+                quat_x.emplace_back(_quat_x);
+                quat_y.emplace_back(_quat_y);
+                quat_z.emplace_back(_quat_z);
+                quat_w.emplace_back(_quat_w);
+            }
+            stats.rows = imu_timestamps.size();
+        }));
+
+        tasks.emplace_back(pool.submit([&, &stats = ingestStats[4]] {
+            IngestTimer timer(stats);
+            std::string path = sessionPath + stats.file;
+            size_t rowCount = estimateRowCount(path);
+            for (auto *column: {&year, &month, &day, &hours, &minutes, &seconds, &nanoseconds}) {
+                column->reserve(rowCount);
+            }
+            imu_gnss_timestamps.reserve(rowCount);
+
+            io::CSVReader<8> in_time(path);
+            long _timestamp;
+            float _year, _month, _day, _hours, _minutes, _seconds, _nanoseconds;
+            while (in_time.read_row(_timestamp, _year, _month, _day, _hours, _minutes, _seconds, _nanoseconds)) {
+                imu_gnss_timestamps.emplace_back(_timestamp);
+
+                year.emplace_back(_year);
+                month.emplace_back(_month);
+                day.emplace_back(_day);
+
+                hours.emplace_back(_hours);
+                minutes.emplace_back(_minutes);
+                seconds.emplace_back(_seconds);
+                nanoseconds.emplace_back(_nanoseconds);
             }
+            stats.rows = imu_gnss_timestamps.size();
+        }));
+
+        tasks.emplace_back(pool.submit([&, &stats = ingestStats[5]] {
+            IngestTimer timer(stats);
+            std::string path = sessionPath + stats.file;
+            size_t rowCount = estimateRowCount(path);
+            for (auto *column: {&latitude, &longitude, &altitude, &azimuth}) {
+                column->reserve(rowCount);
+            }
+            gnss_timestamps.reserve(rowCount);
+
+            io::CSVReader<5> in_pose(path);
+            long _timestamp;
+            float _latitude, _longitude, _altitude, _azimuth;
+            while (in_pose.read_row(_timestamp, _latitude, _longitude, _altitude, _azimuth)) {
+                gnss_timestamps.emplace_back(_timestamp);
+
+                latitude.emplace_back(_latitude);
+                longitude.emplace_back(_longitude);
+                altitude.emplace_back(_altitude);
+                azimuth.emplace_back(_azimuth);
+            }
+            stats.rows = gnss_timestamps.size();
+        }));
 
-            return leftVideo.read(dataset->leftCameraFrame) &&
-                   rightVideo.read(dataset->rightCameraFrame) &&
-                   thermalVideo.read(dataset->thermalCameraFrame);
+        // Parsing errors are rethrown once every task is done, the others still write into the local columns
+        for (auto &task: tasks) {
+            task.wait();
         }
-        return false;
+        for (auto &task: tasks) {
+            task.get();
+        }
+
+        fmt::print("Sensor log ingestion breakdown:\n");
+        for (const auto &stats: ingestStats) {
+            fmt::print("  {:<36} {:>10} rows {:>10.2f} ms\n", stats.file, stats.rows, stats.time);
+        }
+
+        return SensorLogCache::write(cachePath, stamp, {
+                {"timestamps",          timestamps},
+                {"right_timestamps",    right_timestamps},
+                {"thermal_timestamps",  thermal_timestamps},
+                {"imu_timestamps",      imu_timestamps},
+                {"imu_gnss_timestamps", imu_gnss_timestamps},
+                {"gnss_timestamps",     gnss_timestamps},
+                {"acc_x",               acc_x},
+                {"acc_y",               acc_y},
+                {"acc_z",               acc_z},
+                {"ang_vel_x",           ang_vel_x},
+                {"ang_vel_y",           ang_vel_y},
+                {"ang_vel_z",           ang_vel_z},
+                {"quat_x",              quat_x},
+                {"quat_y",              quat_y},
+                {"quat_z",              quat_z},
+                {"quat_w",              quat_w},
+                {"year",                year},
+                {"month",               month},
+                {"day",                 day},
+                {"hours",               hours},
+                {"minutes",             minutes},
+                {"seconds",             seconds},
+                {"nanoseconds",         nanoseconds},
+                {"latitude",            latitude},
+                {"longitude",           longitude},
+                {"altitude",            altitude},
+                {"azimuth",             azimuth},
+                {"min_temp",            min_temp},
+                {"max_temp",            max_temp}});
     }
 
-private:
     Dataset *dataset;
+    std::string sessionPath;
 
-    std::vector<long> timestamps;
-    std::vector<long> thermal_timestamps;
-    std::vector<long> imu_timestamps;
-    std::vector<long> imu_gnss_timestamps;
-    std::vector<long> gnss_timestamps;
+    SensorLogCache sensorLogCache;
 
-    std::vector<double> acc_x, acc_y, acc_z, ang_vel_x, ang_vel_y, ang_vel_z, quat_x, quat_y, quat_z, quat_w;
-    std::vector<double> year, month, day, hours, minutes, seconds, nanoseconds;
-    std::vector<double> latitude, longitude, altitude, azimuth;
-    std::vector<double> min_temp, max_temp;
+    ColumnSpan<long> timestamps;
+    ColumnSpan<long> right_timestamps;
+    ColumnSpan<long> thermal_timestamps;
+    ColumnSpan<long> imu_timestamps;
+    ColumnSpan<long> imu_gnss_timestamps;
+    ColumnSpan<long> gnss_timestamps;
 
-    SunSet sunCalc = SunSet();
+    ColumnSpan<double> acc_x, acc_y, acc_z, ang_vel_x, ang_vel_y, ang_vel_z, quat_x, quat_y, quat_z, quat_w;
+    ColumnSpan<double> year, month, day, hours, minutes, seconds, nanoseconds;
+    ColumnSpan<double> latitude, longitude, altitude, azimuth;
+    ColumnSpan<double> min_temp, max_temp;
 
-    long imu_index = 0;
-    long gnss_index = 0;
-    long previousTimeDif = INT_MAX;
+    FrameMetadataTable frameMetadata;
+    SunSet sunCalc = SunSet();
 
     // Camera
-    cv::VideoCapture leftVideo{SESSION_PATH + std::string(LEFT_VIDEO_PATH)};
-    cv::VideoCapture rightVideo{SESSION_PATH + std::string(RIGHT_VIDEO_PATH)};
-    cv::VideoCapture thermalVideo{SESSION_PATH + std::string(THERMAL_VIDEO_PATH)};
+    FramePrefetcher framePrefetcher;
 
-    double totalFrames = leftVideo.get(cv::CAP_PROP_FRAME_COUNT);
+    bool isSpillEnabled;
 };
 
 
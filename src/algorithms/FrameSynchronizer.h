@@ -0,0 +1,40 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "../util/ColumnSpan.h"
+
+#include <cstdlib>
+#include <vector>
+
+// Result of matching one stream onto the reference camera timeline
+struct StreamSync {
+    std::vector<uint32_t> frameIndices; // Matched stream frame for every reference frame
+    std::vector<long> syncErrors;       // Stream timestamp minus reference timestamp of the matched frames
+};
+
+class FrameSynchronizer {
+public:
+    // Picks the frame with the nearest timestamp for every reference frame.
+    // Both timestamp tables are sorted, so the matched indices never go backwards and a single merge pass is enough.
+    // A stream without timestamps has no matches, so its users fall back to the reference frame index.
+    static StreamSync match(ColumnSpan<long> referenceTimestamps, ColumnSpan<long> streamTimestamps) {
+        StreamSync sync;
+        if (streamTimestamps.empty()) return sync;
+        sync.frameIndices.resize(referenceTimestamps.size());
+        sync.syncErrors.resize(referenceTimestamps.size());
+
+        size_t j = 0;
+        for (size_t i = 0; i < referenceTimestamps.size(); i++) {
+            long t = referenceTimestamps[i];
+            while (j + 1 < streamTimestamps.size() &&
+                   std::labs(streamTimestamps[j + 1] - t) <= std::labs(streamTimestamps[j] - t)) {
+                j++;
+            }
+            sync.frameIndices[i] = uint32_t(j);
+            sync.syncErrors[i] = streamTimestamps[j] - t;
+        }
+        return sync;
+    }
+};
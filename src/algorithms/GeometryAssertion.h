@@ -8,7 +8,7 @@
 #include <fmt/core.h>
 #include "../threading/BS_thread_pool.h"
 
-void detectKeypoints(const cv::Mat &frame, Dataset *dataset, bool isLeft) {
+inline void detectKeypoints(const cv::Mat &frame, Dataset *dataset, bool isLeft) {
     auto leftROI = cv::Rect(dataset->cameraWidth / 2, 0, dataset->cameraWidth / 2, dataset->cameraHeight);
     auto rightROI = cv::Rect(0, 0, dataset->cameraWidth / 2, dataset->cameraHeight);
     auto imageROI = cv::Mat(frame, isLeft ? leftROI : rightROI);
@@ -27,8 +27,8 @@ void detectKeypoints(const cv::Mat &frame, Dataset *dataset, bool isLeft) {
 
 // ORB Feature detector and descriptor, matched using Bruteforce matcher.
 // There needs to be certain number of matched points and their y offset needs to be sufficiently low to qualify for proper geometry
-void assertCameraGeometry(Dataset *dataset, const cv::Mat &leftCameraFrameGray, const cv::Mat &rightCameraFrameGray,
-                          BS::thread_pool &pool) {
+inline void assertCameraGeometry(Dataset *dataset, const cv::Mat &leftCameraFrameGray, const cv::Mat &rightCameraFrameGray,
+                                 BS::thread_pool &pool) {
 
     // Detect features
     pool.push_task(detectKeypoints, leftCameraFrameGray, dataset, true);
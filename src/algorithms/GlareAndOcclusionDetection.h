@@ -7,7 +7,7 @@
 #include "opencv4/opencv2/opencv.hpp"
 #include <fmt/core.h>
 
-void detectGlareAndOcclusion(const cv::Mat &cameraFrameGray, Dataset *dataset) {
+inline void detectGlareAndOcclusion(const cv::Mat &cameraFrameGray, Dataset *dataset) {
     Timer timer("Glare and occlusion detection", &dataset->glareAndOcclusionDetection);
 
     // Step 1: Convert the frame to a color space that maximizes resolution in luminance
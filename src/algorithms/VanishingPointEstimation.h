@@ -5,7 +5,7 @@
 
 #include "DatasetFileReader.h"
 
-void estimateVanishingPointPosition(Dataset* dataset) {
+inline void estimateVanishingPointPosition(Dataset* dataset) {
     Timer timer("Vanishing point estimation", &dataset->vanishingPointEstimation);
 
     // Estimate position of the road vanishing point
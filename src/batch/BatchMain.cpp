@@ -0,0 +1,149 @@
+//
+// Created by standa on 16.10.26.
+//
+
+// Headless reprocessing of many sessions, built as a separate executable without the Vulkan front end.
+// Usage: VulkanComputeBatch [--jobs N] [--memory-budget MB] [--shards N] [--warmup N] [--output-dir DIR] SESSION...
+// Every SESSION is a session directory or a glob pattern matching session directories.
+
+#include "../GlobalConfiguration.h"
+#include "SessionJobQueue.h"
+
+#include <fmt/core.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glob.h>
+#include <sys/stat.h>
+
+static bool isDirectory(const std::string &path) {
+    struct stat pathStat{};
+    return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+}
+
+static std::vector<std::string> expandSessions(const std::string &pattern) {
+    std::vector<std::string> sessions;
+
+    glob_t matches{};
+    if (glob(pattern.c_str(), GLOB_TILDE, nullptr, &matches) == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; i++) {
+            std::string path = matches.gl_pathv[i];
+            if (!isDirectory(path)) continue;
+
+            // Session paths are concatenated with the relative file paths, so they need the trailing separator
+            if (path.back() != '/') path += '/';
+            sessions.push_back(path);
+        }
+    }
+    globfree(&matches);
+
+    return sessions;
+}
+
+static std::string sessionName(const std::string &sessionPath) {
+    std::string path = sessionPath.substr(0, sessionPath.find_last_not_of('/') + 1);
+    return path.substr(path.find_last_of('/') + 1);
+}
+
+int main(int argc, char **argv) {
+    uint32_t concurrency = BATCH_CONCURRENCY;
+    size_t memoryBudget = size_t(BATCH_MEMORY_BUDGET_MB) * 1024 * 1024;
+    uint32_t shardsPerSession = 1;
+    uint32_t warmupFrames = BATCH_WARMUP_FRAMES;
+    std::string outputDirectory;
+    std::vector<std::string> sessions;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "--jobs" && i + 1 < argc) {
+                concurrency = uint32_t(std::stoul(argv[++i]));
+            } else if (argument == "--memory-budget" && i + 1 < argc) {
+                memoryBudget = size_t(std::stoull(argv[++i])) * 1024 * 1024;
+            } else if (argument == "--shards" && i + 1 < argc) {
+                shardsPerSession = uint32_t(std::stoul(argv[++i]));
+            } else if (argument == "--warmup" && i + 1 < argc) {
+                warmupFrames = uint32_t(std::stoul(argv[++i]));
+            } else if (argument == "--output-dir" && i + 1 < argc) {
+                outputDirectory = argv[++i];
+                if (outputDirectory.empty()) throw std::invalid_argument("Empty output directory");
+                if (outputDirectory.back() != '/') outputDirectory += '/';
+            } else {
+                std::vector<std::string> matched = expandSessions(argument);
+                if (matched.empty()) fmt::print("No session directory matches {}\n", argument);
+                sessions.insert(sessions.end(), matched.begin(), matched.end());
+            }
+        }
+    } catch (const std::logic_error &) {
+        // Thrown by std::stoul for values which aren't numbers or don't fit and for an empty output directory
+        fmt::print("Usage: {} [--jobs N] [--memory-budget MB] [--shards N] [--warmup N] [--output-dir DIR] SESSION...\n",
+                   argv[0]);
+        return 1;
+    }
+
+    if (sessions.empty()) {
+        fmt::print("Usage: {} [--jobs N] [--memory-budget MB] [--shards N] [--warmup N] [--output-dir DIR] SESSION...\n",
+                   argv[0]);
+        return 1;
+    }
+
+    // Fail before processing anything rather than after every session when writing its results
+    if (!outputDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(outputDirectory, error);
+        if (error) {
+            fmt::print("Failed to create the output directory {}: {}\n", outputDirectory, error.message());
+            return 1;
+        }
+    }
+
+    std::vector<SessionJob> jobs;
+    for (const auto &session: sessions) {
+        std::string outputPath = outputDirectory.empty() ? session + "results.csv"
+                                                         : outputDirectory + sessionName(session) + ".csv";
+        jobs.push_back({session, outputPath, SessionShardRunner::estimateMemory(session, shardsPerSession)});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    SessionJobQueue queue(concurrency, memoryBudget, shardsPerSession, warmupFrames);
+    std::vector<SessionReport> reports = queue.run(jobs);
+    std::chrono::duration<float> wallTime = std::chrono::steady_clock::now() - start;
+
+    // Summary
+    std::string summaryPath = outputDirectory + "batch_summary.csv";
+    std::ofstream summary(summaryPath, std::ios::trunc);
+    summary << "session,output,frames,seconds,fps,status\n";
+
+    size_t totalFrames = 0;
+    int failedSessions = 0;
+    fmt::print("{:<48} {:>10} {:>10} {:>10}\n", "Session", "Frames", "Time [s]", "FPS");
+    for (const auto &report: reports) {
+        float fps = report.seconds > 0.0f ? float(report.frames) / report.seconds : 0.0f;
+        std::string status = report.isOk ? "ok" : report.error;
+        fmt::print("{:<48} {:>10} {:>10.1f} {:>10.1f} {}\n", sessionName(report.sessionPath), report.frames,
+                   report.seconds, fps, report.isOk ? "" : status);
+        summary << fmt::format("{},{},{},{:.3f},{:.3f},\"{}\"\n", report.sessionPath, report.outputPath,
+                               report.frames, report.seconds, fps, status);
+
+        totalFrames += report.frames;
+        if (!report.isOk) failedSessions++;
+    }
+
+    float aggregateFps = wallTime.count() > 0.0f ? float(totalFrames) / wallTime.count() : 0.0f;
+    fmt::print("Processed {} frames of {} sessions in {:.1f} s, aggregate {:.1f} FPS, {} failed\n", totalFrames,
+               reports.size(), wallTime.count(), aggregateFps, failedSessions);
+    summary << fmt::format("total,,{},{:.3f},{:.3f},\"{} failed\"\n", totalFrames, wallTime.count(), aggregateFps,
+                           failedSessions);
+
+    summary.close();
+    if (!summary) {
+        fmt::print("Failed to write the batch summary into {}\n", summaryPath);
+        return 1;
+    }
+
+    return failedSessions == 0 ? 0 : 1;
+}
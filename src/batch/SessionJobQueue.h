@@ -0,0 +1,114 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "SessionShardRunner.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SessionJob {
+    std::string sessionPath;
+    std::string outputPath;
+    size_t memoryEstimate = 0;
+};
+
+struct SessionReport {
+    std::string sessionPath;
+    std::string outputPath;
+    size_t frames = 0;
+    float seconds = 0.0f;
+    bool isOk = false;
+    std::string error;
+};
+
+// Runs sessions on a fixed number of workers. A session is started only when its memory estimate fits into
+// what is left of the budget, one session is always allowed to run so an oversized one can't block the queue.
+// Sessions are started in the given order.
+class SessionJobQueue {
+public:
+    SessionJobQueue(uint32_t _concurrency, size_t _memoryBudget, uint32_t _shardsPerSession, uint32_t _warmupFrames)
+            : concurrency(std::max(_concurrency, 1u)), memoryBudget(_memoryBudget),
+              shardsPerSession(std::max(_shardsPerSession, 1u)), warmupFrames(_warmupFrames) {}
+
+    std::vector<SessionReport> run(const std::vector<SessionJob> &jobs) {
+        reports.assign(jobs.size(), {});
+        nextJob = 0;
+        memoryUsed = 0;
+        runningJobs = 0;
+
+        std::vector<std::thread> workers;
+        for (uint32_t w = 0; w < std::min<size_t>(concurrency, jobs.size()); w++) {
+            workers.emplace_back(&SessionJobQueue::worker, this, std::cref(jobs));
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+        return reports;
+    }
+
+private:
+    void worker(const std::vector<SessionJob> &jobs) {
+        unsigned int threadCount = std::max(std::thread::hardware_concurrency() / concurrency, 1u);
+
+        while (true) {
+            size_t jobIndex;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                admission.wait(lock, [&] {
+                    return nextJob >= jobs.size() || runningJobs == 0 ||
+                           memoryUsed + jobs[nextJob].memoryEstimate <= memoryBudget;
+                });
+                if (nextJob >= jobs.size()) return;
+
+                jobIndex = nextJob++;
+                memoryUsed += jobs[jobIndex].memoryEstimate;
+                runningJobs++;
+            }
+
+            const SessionJob &job = jobs[jobIndex];
+            SessionReport &report = reports[jobIndex];
+            report.sessionPath = job.sessionPath;
+            report.outputPath = job.outputPath;
+
+            auto start = std::chrono::steady_clock::now();
+            try {
+                SessionShardRunner runner(job.sessionPath, shardsPerSession, warmupFrames, threadCount);
+                std::vector<FrameResult> results = runner.run();
+                report.frames = results.size();
+                report.isOk = SessionShardRunner::writeResults(job.outputPath, results);
+                if (!report.isOk) report.error = "Failed to write " + job.outputPath;
+            } catch (const std::exception &e) {
+                report.error = e.what();
+            }
+            std::chrono::duration<float> duration = std::chrono::steady_clock::now() - start;
+            report.seconds = duration.count();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                memoryUsed -= job.memoryEstimate;
+                runningJobs--;
+            }
+            admission.notify_all();
+        }
+    }
+
+    uint32_t concurrency;
+    size_t memoryBudget;
+    uint32_t shardsPerSession;
+    uint32_t warmupFrames;
+
+    std::vector<SessionReport> reports;
+
+    std::mutex mutex;
+    std::condition_variable admission;
+    size_t nextJob = 0;
+    size_t memoryUsed = 0;
+    uint32_t runningJobs = 0;
+};
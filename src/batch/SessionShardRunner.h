@@ -0,0 +1,169 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "../GlobalConfiguration.h"
+#include "../util/Dataset.h"
+#include "../profiling/Timer.h"
+#include "../threading/BS_thread_pool.h"
+#include "../algorithms/DatasetFileReader.h"
+#include "../algorithms/CameraAlgorithms.h"
+
+#include <fmt/core.h>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Outputs of the CPU algorithms for a single frame
+struct FrameResult {
+    uint32_t frameIndex;
+    int hours, minutes, seconds;
+    double latitude, longitude;
+    double heading, attitude;
+    int vanishingPointX, vanishingPointY;
+    double vpVisibility;
+    double visibilityScore;
+    double glareAmount;
+    int occludedRegions;
+    bool geometryOk;
+    bool isDaylight;
+};
+
+// Processes one session headless, split into time ranges which run in parallel.
+// Every shard has its own decoders, Dataset and thread pool. It starts warmupFrames before its range,
+// so the stateful results (vp_visibility moving average, occlusion buffers) converge before they are recorded.
+class SessionShardRunner {
+public:
+    SessionShardRunner(std::string _sessionPath, uint32_t _shardCount, uint32_t _warmupFrames = BATCH_WARMUP_FRAMES,
+                       unsigned int _threadCount = std::thread::hardware_concurrency())
+            : sessionPath(std::move(_sessionPath)), shardCount(std::max(_shardCount, 1u)), warmupFrames(_warmupFrames),
+              threadCount(std::max(_threadCount, 1u)) {}
+
+    // Rough peak memory of a run: decoded frames held by every shard's prefetch ring and Dataset plus the metadata table
+    static size_t estimateMemory(const std::string &sessionPath, uint32_t shardCount) {
+        size_t frameSetBytes = 0;
+        size_t frameCount = 0;
+        for (const char *video: {LEFT_VIDEO_PATH, RIGHT_VIDEO_PATH, THERMAL_VIDEO_PATH}) {
+            cv::VideoCapture capture(sessionPath + std::string(video));
+            frameSetBytes += size_t(capture.get(cv::CAP_PROP_FRAME_WIDTH) * capture.get(cv::CAP_PROP_FRAME_HEIGHT) * 3);
+            frameCount = std::max(frameCount, size_t(capture.get(cv::CAP_PROP_FRAME_COUNT)));
+        }
+
+        size_t perShard = frameSetBytes * (FRAME_PREFETCH_DEPTH + 2) + frameCount * sizeof(double) * 24;
+        return perShard * std::max(shardCount, 1u);
+    }
+
+    // Returns the results of all frames ordered by frame index
+    std::vector<FrameResult> run() {
+        Timer timer("Sharded session processing");
+
+        auto totalFrames = uint32_t(
+                cv::VideoCapture(sessionPath + std::string(LEFT_VIDEO_PATH)).get(cv::CAP_PROP_FRAME_COUNT));
+        uint32_t rangeLength = (totalFrames + shardCount - 1) / shardCount;
+        unsigned int shardThreads = std::max(threadCount / shardCount, 1u);
+
+        // Shards are created one by one, the first one also creates the sensor log and keyframe caches for the others
+        std::vector<std::unique_ptr<Shard>> shards;
+        for (uint32_t s = 0; s < shardCount; s++) {
+            uint32_t start = s * rangeLength;
+            uint32_t end = std::min(start + rangeLength, totalFrames);
+            if (start >= end) break;
+
+            shards.emplace_back(std::make_unique<Shard>(sessionPath, start, end, start - std::min(start, warmupFrames),
+                                                        shardThreads));
+        }
+
+        std::vector<std::thread> workers;
+        for (auto &shard: shards) {
+            workers.emplace_back(&SessionShardRunner::processShard, shard.get());
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+        // Failures are rethrown only after every shard stopped, so the caller sees them instead of std::terminate
+        for (auto &shard: shards) {
+            if (shard->error) std::rethrow_exception(shard->error);
+        }
+
+        // Ranges are disjoint and ordered, so the merge is a concatenation
+        std::vector<FrameResult> results;
+        results.reserve(totalFrames);
+        for (auto &shard: shards) {
+            results.insert(results.end(), shard->results.begin(), shard->results.end());
+        }
+        return results;
+    }
+
+    static bool writeResults(const std::string &path, const std::vector<FrameResult> &results) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        file << "frame_index,hours,minutes,seconds,latitude,longitude,heading,attitude,vp_x,vp_y,vp_visibility,"
+                "visibility_score,glare_amount,occluded_regions,geometry_ok,is_daylight\n";
+        for (const auto &r: results) {
+            file << fmt::format("{},{},{},{},{:.7f},{:.7f},{:.4f},{:.6f},{},{},{:.6f},{},{:.3f},{},{},{}\n",
+                                r.frameIndex, r.hours, r.minutes, r.seconds, r.latitude, r.longitude, r.heading,
+                                r.attitude, r.vanishingPointX, r.vanishingPointY, r.vpVisibility, r.visibilityScore,
+                                r.glareAmount, r.occludedRegions, int(r.geometryOk), int(r.isDaylight));
+        }
+        return bool(file);
+    }
+
+    static FrameResult collectFrameResult(Dataset *dataset) {
+        int occludedRegions = 0;
+        for (auto &buffer: dataset->occlusionBuffers) {
+            if (buffer.dataSum() == 0) occludedRegions++;
+        }
+
+        return {dataset->frameIndex, dataset->hours, dataset->minutes, dataset->seconds, dataset->latitude,
+                dataset->longitude, dataset->heading.empty() ? 0.0 : dataset->heading.back(),
+                dataset->attitude.empty() ? 0.0 : dataset->attitude.back(), dataset->vanishingPoint.first,
+                dataset->vanishingPoint.second, dataset->vp_visibility.empty() ? 1.0 : dataset->vp_visibility.back(),
+                dataset->visibilityScore, cv::mean(dataset->glareAmounts)[0], occludedRegions, dataset->geometryOk,
+                dataset->isDaylight};
+    }
+
+private:
+    struct Shard {
+        uint32_t start, end;
+        BS::thread_pool pool;
+        Dataset dataset{};
+        std::unique_ptr<DatasetFileReader> reader;
+        std::vector<FrameResult> results;
+        std::exception_ptr error;
+
+        Shard(const std::string &sessionPath, uint32_t _start, uint32_t _end, uint32_t warmupStart,
+              unsigned int threads) : start(_start), end(_end), pool(threads) {
+            // Shards only cover a part of the session, the history spill is left to a single reader of the whole session
+            reader = std::make_unique<DatasetFileReader>(&dataset, pool, warmupStart, sessionPath, false);
+            results.reserve(end - start);
+        }
+    };
+
+    static void processShard(Shard *shard) {
+        Dataset *dataset = &shard->dataset;
+        try {
+            while (true) {
+                runCameraAlgorithms(dataset, shard->pool);
+                if (dataset->frameIndex >= shard->start) {
+                    shard->results.push_back(collectFrameResult(dataset));
+                }
+
+                if (dataset->frameIndex + 1 >= shard->end) break;
+                dataset->frameIndex++;
+                if (!shard->reader->readData(shard->pool)) break;
+            }
+        } catch (...) {
+            shard->error = std::current_exception();
+        }
+    }
+
+    std::string sessionPath;
+    uint32_t shardCount;
+    uint32_t warmupFrames;
+    unsigned int threadCount;
+};
@@ -1,5 +1,6 @@
 #include "VulkanEngineEntryPoint.h"
 
+#include <stdexcept>
 #include <string>
 #include <dlfcn.h>
 
@@ -8,58 +9,53 @@
 #include "../external/renderdoc/renderdoc_app.h"
 
 #include "algorithms/DatasetFileReader.h"
-#include "algorithms/VisibilityCalculation.h"
-#include "algorithms/GlareAndOcclusionDetection.h"
-#include "algorithms/VanishingPointEstimation.h"
-#include "algorithms/GeometryAssertion.h"
+#include "algorithms/CameraAlgorithms.h"
+#include "batch/SessionShardRunner.h"
 
 #include "threading/BS_thread_pool.h"
+#include "threading/FramePipeline.h"
 
 RENDERDOC_API_1_1_2 *rdoc_api = nullptr;
 
-void runCameraAlgorithms(Dataset *dataset, BS::thread_pool &pool) {
-    if (dataset != nullptr && dataset->frameIndex != 0) {
-        Timer tim("All CPU algorithms", &dataset->allCPUAlgorithms);
-
-        cv::Mat leftCameraFrameGray;
-        cv::Mat rightCameraFrameGray;
-        cv::cvtColor(dataset->leftCameraFrame, leftCameraFrameGray, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(dataset->rightCameraFrame, rightCameraFrameGray, cv::COLOR_BGR2GRAY);
-
-        estimateVanishingPointPosition(dataset);
-
-        // Algorithms run in parallel pool
-        pool.push_task(VisibilityCalculation::calculateVisibilityVp, leftCameraFrameGray, dataset,
-                       dataset->vanishingPoint);
-        pool.push_task(detectGlareAndOcclusion, leftCameraFrameGray, dataset);
-
-        {
-            Timer t("Fog detection", &dataset->fogDetection);
-            for (int j = 0; j < DFT_BLOCK_COUNT; j++) {
-                for (int i = 0; i < DFT_BLOCK_COUNT; i++) {
-                    int w = (DFT_WINDOW_SIZE / 2) +
-                            (i * ((dataset->cameraWidth - DFT_WINDOW_SIZE) / (DFT_BLOCK_COUNT - 1)));
-                    int h = (DFT_WINDOW_SIZE / 2) +
-                            (j * ((dataset->cameraHeight - DFT_WINDOW_SIZE) / (DFT_BLOCK_COUNT - 1)));
-
-                    pool.push_task(VisibilityCalculation::calculateVisibility, leftCameraFrameGray, dataset,
-                                   std::pair(w, h),
-                                   std::pair(i, j));
-                }
+int main(int argc, char **argv) {
+    uint32_t startFrame = 0;
+    uint32_t shardCount = 0, warmupFrames = BATCH_WARMUP_FRAMES;
+    bool isMinFilterBenchmark = false;
+    std::string outputPath = std::string(SESSION_PATH) + "results.csv";
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string argument = argv[i];
+            if (argument == "--start-frame" && i + 1 < argc) {
+                startFrame = uint32_t(std::stoul(argv[++i]));
+            } else if (argument == "--shards" && i + 1 < argc) {
+                shardCount = uint32_t(std::stoul(argv[++i]));
+            } else if (argument == "--warmup" && i + 1 < argc) {
+                warmupFrames = uint32_t(std::stoul(argv[++i]));
+            } else if (argument == "--output" && i + 1 < argc) {
+                outputPath = argv[++i];
+            } else if (argument == "--benchmark-min-filter") {
+                isMinFilterBenchmark = true;
             }
-            pool.wait_for_tasks();
         }
+    } catch (const std::logic_error &) {
+        // Thrown by std::stoul for values which aren't numbers or don't fit
+        fmt::print("Usage: {} [--start-frame N] [--shards N] [--warmup N] [--output FILE] [--benchmark-min-filter]\n",
+                   argv[0]);
+        return 1;
+    }
 
-        {
-            Timer timer("Assert camera geometry");
-            assertCameraGeometry(dataset, leftCameraFrameGray, rightCameraFrameGray, pool);
+    // Headless batch mode, the session is split into time ranges processed in parallel
+    if (shardCount > 0) {
+        SessionShardRunner runner(SESSION_PATH, shardCount, warmupFrames);
+        std::vector<FrameResult> results = runner.run();
+        if (!SessionShardRunner::writeResults(outputPath, results)) {
+            fmt::print("Failed to write results into {}\n", outputPath);
+            return 1;
         }
-
-        VisibilityCalculation::calculateVisibilityScore(dataset);
+        fmt::print("Processed {} frames into {}\n", results.size(), outputPath);
+        return 0;
     }
-}
 
-int main() {
 #if RENDERDOC_ENABLED
     // Initialize RenderDoc API
     if (void *mod = dlopen("../external/renderdoc/librenderdoc.so", RTLD_NOW)) {
@@ -75,14 +71,105 @@ int main() {
     BS::thread_pool pool(std::thread::hardware_concurrency() - 1);
 
     auto *dataset = new Dataset();
-    auto *datasetFileReader = new DatasetFileReader(dataset, pool);
-    auto *entryPoint = new VulkanEngineEntryPoint(dataset);
+    DatasetFileReader *datasetFileReader;
+    try {
+        datasetFileReader = new DatasetFileReader(dataset, pool, startFrame);
+    } catch (const std::out_of_range &e) {
+        fmt::print("{}\n", e.what());
+        delete dataset;
+        return 1;
+    }
+    auto *entryPoint = new VulkanEngineEntryPoint(dataset, pool);
+#if ZERO_COPY_DECODE_ENABLED
+    datasetFileReader->setFrameAllocator(entryPoint->getFrameAllocator());
+#endif
 
+    // Times the dark channel filter on the first frame for every radius and exits
+    if (isMinFilterBenchmark) {
+        entryPoint->render();
+        entryPoint->benchmarkMinFilter();
+        delete datasetFileReader;
+        delete dataset;
+        delete entryPoint;
+        return 0;
+    }
+
+    // The reader already holds the first frame after construction
+    bool isFrameLoaded = true;
+#if FRAME_PIPELINE_ENABLED
+    // The first frame is shown from the dataset itself, the following ones come from the pipeline slots.
+    // From then on the dataset only holds the history the pipeline carries between frames.
+    auto *framePipeline = new FramePipeline(*datasetFileReader, dataset, pool);
+    Dataset *shownDataset = dataset;
+#endif
     while (entryPoint->isRunning) {
         entryPoint->handleEvents();
+
+#if FRAME_PIPELINE_ENABLED
+        // Seeking from the scrub bar works even when paused or at the end of the session
+        bool isSeeking = shownDataset->seekFrameIndex >= 0;
+        if (isSeeking) {
+            entryPoint->isFinished = false;
+        }
+
+        if (!entryPoint->isFinished) {
+            if (!entryPoint->isPaused || isSeeking) {
+                if (isSeeking || !isFrameLoaded) {
+                    if (isSeeking) {
+                        auto seekFrameIndex = uint32_t(shownDataset->seekFrameIndex);
+                        shownDataset->seekFrameIndex = -1;
+                        entryPoint->isFinished = !framePipeline->seek(seekFrameIndex);
+                    } else if (!framePipeline->isStarted()) {
+                        framePipeline->start(shownDataset->frameIndex + 1);
+                    }
+
+                    Dataset *nextDataset = entryPoint->isFinished ? nullptr : framePipeline->pop();
+                    if (nextDataset != nullptr) {
+                        nextDataset->showVanishingPoint = shownDataset->showVanishingPoint;
+                        nextDataset->showKeypoints = shownDataset->showKeypoints;
+                        nextDataset->useFusedDehaze = shownDataset->useFusedDehaze;
+                        nextDataset->useTopDarkChannelAirLight = shownDataset->useTopDarkChannelAirLight;
+                        nextDataset->darkChannelRadius = shownDataset->darkChannelRadius;
+                        nextDataset->guidedFilterRadius = shownDataset->guidedFilterRadius;
+                        nextDataset->guidedFilterEpsilon = shownDataset->guidedFilterEpsilon;
+                        shownDataset = nextDataset;
+                        entryPoint->setDataset(shownDataset);
+                        entryPoint->prepareNextFrame();
+                    } else {
+                        entryPoint->isFinished = true;
+                    }
+                }
+
+#if RENDERDOC_ENABLED
+                if (rdoc_api) rdoc_api->StartFrameCapture(nullptr, nullptr);
+#endif
+
+                entryPoint->render();
+
+#if RENDERDOC_ENABLED
+                if (rdoc_api) rdoc_api->EndFrameCapture(nullptr, nullptr);
+#endif
+                isFrameLoaded = false;
+#if TIMER_ON
+                fmt::print("--------------------------------------------------------------------------------------------\n");
+#endif
+            }
+        }
+#else
+        // Seeking from the scrub bar works even when paused or at the end of the session
+        bool isSeeking = dataset->seekFrameIndex >= 0;
+        if (isSeeking) {
+            entryPoint->isFinished = false;
+        }
+
         if (!entryPoint->isFinished) {
-            if (!entryPoint->isPaused) {
-                if (dataset->frameIndex > 0) {
+            if (!entryPoint->isPaused || isSeeking) {
+                if (isSeeking) {
+                    entryPoint->isFinished = !datasetFileReader->seek(uint32_t(dataset->seekFrameIndex), pool);
+                    dataset->seekFrameIndex = -1;
+                    runCameraAlgorithms(dataset, pool);
+                    entryPoint->prepareNextFrame();
+                } else if (!isFrameLoaded) {
                     entryPoint->isFinished = !datasetFileReader->readData(pool);
                     runCameraAlgorithms(dataset, pool);
                     entryPoint->prepareNextFrame();
@@ -97,17 +184,23 @@ int main() {
 #if RENDERDOC_ENABLED
                 if (rdoc_api) rdoc_api->EndFrameCapture(nullptr, nullptr);
 #endif
+                isFrameLoaded = false;
                 dataset->frameIndex++;
 #if TIMER_ON
                 fmt::print("--------------------------------------------------------------------------------------------\n");
 #endif
             }
         }
+#endif
     }
 
-    delete entryPoint;
+#if FRAME_PIPELINE_ENABLED
+    delete framePipeline;
+#endif
+    // Frames may be allocated by the entry point, so it goes last
     delete datasetFileReader;
     delete dataset;
+    delete entryPoint;
 
     return 0;
 }
\ No newline at end of file
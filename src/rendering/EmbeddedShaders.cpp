@@ -0,0 +1,18 @@
+//
+// Created by standa on 16.10.26.
+//
+#include "EmbeddedShaders.h"
+
+// Generated by CMake, includes the SPIR-V array of every shader and lists them in EMBEDDED_SHADERS
+#include "EmbeddedShaderList.h"
+
+static const EmbeddedShader embeddedShaders[] = {EMBEDDED_SHADERS};
+
+const EmbeddedShader *findEmbeddedShader(const std::string &name) {
+    for (const EmbeddedShader &shader: embeddedShaders) {
+        if (name == shader.name) {
+            return &shader;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,18 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SPIR-V of a shader in the shaders directory, compiled into the binary at build time
+struct EmbeddedShader {
+    const char *name; // File name of the shader source, e.g. "ImageRadiance.comp"
+    const uint32_t *code;
+    size_t size; // In bytes
+};
+
+// Shader with the given source file name, nullptr when there is no such shader
+const EmbeddedShader *findEmbeddedShader(const std::string &name);
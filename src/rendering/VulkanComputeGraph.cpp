@@ -0,0 +1,378 @@
+//
+// Created by standa on 16.10.26.
+//
+#include "VulkanComputeGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fmt/core.h>
+#include <stdexcept>
+
+VulkanComputeGraph::VulkanComputeGraph(VulkanEngineDevice &device) : engineDevice(device) {}
+
+VulkanComputeGraph::~VulkanComputeGraph() {
+    for (Texture2D &texture: transientTextures) {
+        texture.destroy(engineDevice);
+    }
+}
+
+VulkanComputeGraph::Resource VulkanComputeGraph::importImage(Texture2D &texture, bool isSharedBetweenFrames) {
+    ResourceInfo resource{};
+    resource.texture = &texture;
+    resource.isSharedBetweenFrames = isSharedBetweenFrames;
+    resource.physical = physicalCount++;
+    resources.push_back(resource);
+    return Resource(resources.size() - 1);
+}
+
+VulkanComputeGraph::Resource VulkanComputeGraph::importBuffer(VulkanEngineBuffer &buffer, bool isSharedBetweenFrames) {
+    ResourceInfo resource{};
+    resource.buffer = &buffer;
+    resource.isSharedBetweenFrames = isSharedBetweenFrames;
+    resource.physical = physicalCount++;
+    resources.push_back(resource);
+    return Resource(resources.size() - 1);
+}
+
+VulkanComputeGraph::Resource VulkanComputeGraph::createTransientImage(uint32_t width, uint32_t height,
+                                                                      VkFormat format) {
+    ResourceInfo resource{};
+    resource.isTransient = true;
+    resource.width = width;
+    resource.height = height;
+    resource.format = format;
+    resources.push_back(resource);
+    return Resource(resources.size() - 1);
+}
+
+void VulkanComputeGraph::addPass(Pass pass) {
+    assert(!isCompiled && "Can't add passes to a compiled graph");
+    entries.push_back(Entry{std::move(pass), nullptr});
+}
+
+void VulkanComputeGraph::addCommands(std::function<void(VkCommandBuffer)> commands) {
+    assert(!isCompiled && "Can't add commands to a compiled graph");
+    entries.push_back(Entry{Pass{}, std::move(commands)});
+}
+
+void VulkanComputeGraph::markOutput(Resource resource, VkPipelineStageFlags stage, VkAccessFlags access) {
+    assert(!resources.at(resource).isTransient && "Transient images can't outlive the graph");
+    resources.at(resource).outputStage = stage;
+    resources.at(resource).outputAccess = access;
+}
+
+void VulkanComputeGraph::compile() {
+    assert(!isCompiled && "The graph is compiled only once");
+    cullPasses();
+    aliasTransientImages();
+    writeDescriptorSets();
+    isCompiled = true;
+}
+
+// A pass is kept if it writes a resource needed by the outputs or by a later pass which is kept. Passes writing
+// the same resource are all kept, as a pass may overwrite only a part of it.
+void VulkanComputeGraph::cullPasses() {
+    std::vector<bool> isNeeded(resources.size());
+    for (size_t i = 0; i < resources.size(); i++) {
+        isNeeded[i] = resources[i].outputStage != 0;
+    }
+
+    for (auto entry = entries.rbegin(); entry != entries.rend(); ++entry) {
+        if (entry->commands) {
+            continue;
+        }
+
+        entry->isCulled = std::none_of(entry->pass.bindings.begin(), entry->pass.bindings.end(),
+                                       [&isNeeded](const Binding &binding) {
+                                           return isWritten(binding.access) && isNeeded[binding.resource];
+                                       });
+        if (!entry->isCulled) {
+            for (const Binding &binding: entry->pass.bindings) {
+                if (isRead(binding.access)) {
+                    isNeeded[binding.resource] = true;
+                }
+            }
+        }
+    }
+}
+
+// Transient images are assigned to textures in the order of their first use, each one takes the first texture of
+// its size and format which is no longer used by then
+void VulkanComputeGraph::aliasTransientImages() {
+    std::vector<int32_t> firstUse(resources.size(), -1);
+    std::vector<int32_t> lastUse(resources.size(), -1);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].commands || entries[i].isCulled) {
+            continue;
+        }
+        for (const Binding &binding: entries[i].pass.bindings) {
+            if (firstUse[binding.resource] < 0) {
+                firstUse[binding.resource] = int32_t(i);
+            }
+            lastUse[binding.resource] = int32_t(i);
+        }
+    }
+
+    std::vector<Resource> transientImages;
+    for (Resource resource = 0; resource < resources.size(); resource++) {
+        if (resources[resource].isTransient && firstUse[resource] >= 0) {
+            transientImages.push_back(resource);
+        }
+    }
+    std::sort(transientImages.begin(), transientImages.end(), [&firstUse](Resource a, Resource b) {
+        return firstUse[a] < firstUse[b];
+    });
+
+    std::vector<VkFormat> textureFormats;
+    std::vector<int32_t> textureLastUse;
+    for (Resource resource: transientImages) {
+        ResourceInfo &image = resources[resource];
+        for (size_t i = 0; i < transientTextures.size(); i++) {
+            if (transientTextures[i].width == image.width && transientTextures[i].height == image.height &&
+                textureFormats[i] == image.format && textureLastUse[i] < firstUse[resource]) {
+                image.transientTexture = int32_t(i);
+                break;
+            }
+        }
+
+        if (image.transientTexture < 0) {
+            image.transientTexture = int32_t(transientTextures.size());
+            transientTextures.emplace_back();
+            transientTextures.back().createTextureTarget(engineDevice, image.width, image.height, image.format);
+            textureFormats.push_back(image.format);
+            textureLastUse.push_back(-1);
+        }
+        textureLastUse[image.transientTexture] = lastUse[resource];
+        image.physical = physicalCount + uint32_t(image.transientTexture);
+    }
+    physicalCount += uint32_t(transientTextures.size());
+
+#if TIMER_ON
+    size_t livePassCount = std::count_if(entries.begin(), entries.end(), [](const Entry &entry) {
+        return !entry.commands && !entry.isCulled;
+    });
+    size_t passCount = std::count_if(entries.begin(), entries.end(), [](const Entry &entry) {
+        return !entry.commands;
+    });
+    fmt::print("Compute graph records {} of {} passes, {} transient images share {} textures\n", livePassCount,
+               passCount, transientImages.size(), transientTextures.size());
+#endif
+}
+
+const Texture2D *VulkanComputeGraph::getTexture(const ResourceInfo &resource) const {
+    return resource.isTransient ? &transientTextures.at(resource.transientTexture) : resource.texture;
+}
+
+// Passes of one pipeline share its descriptor set, so they have to bind the same resources
+void VulkanComputeGraph::writeDescriptorSets() {
+    size_t bindingCount = 0;
+    for (const Entry &entry: entries) {
+        bindingCount += entry.pass.bindings.size();
+    }
+
+    // Writes point into the infos, which therefore never reallocate
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    imageInfos.reserve(bindingCount);
+    bufferInfos.reserve(bindingCount);
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<uint32_t> writtenPhysicals;
+
+    for (const Entry &entry: entries) {
+        if (entry.commands || entry.isCulled || entry.pass.descriptorSet == VK_NULL_HANDLE) {
+            continue;
+        }
+
+        for (const Binding &binding: entry.pass.bindings) {
+            const ResourceInfo &resource = resources.at(binding.resource);
+            auto written = std::find_if(writes.begin(), writes.end(), [&](const VkWriteDescriptorSet &write) {
+                return write.dstSet == entry.pass.descriptorSet && write.dstBinding == binding.binding &&
+                       write.dstArrayElement == binding.arrayElement;
+            });
+            if (written != writes.end()) {
+                if (writtenPhysicals[written - writes.begin()] != resource.physical) {
+                    throw std::runtime_error("Passes of " + entry.pass.name + " bind different resources to binding " +
+                                             std::to_string(binding.binding));
+                }
+                continue;
+            }
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = entry.pass.descriptorSet;
+            write.dstBinding = binding.binding;
+            write.dstArrayElement = binding.arrayElement;
+            write.descriptorCount = 1;
+            if (resource.buffer != nullptr) {
+                bufferInfos.push_back(resource.buffer->getBufferInfo());
+                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                write.pBufferInfo = &bufferInfos.back();
+            } else {
+                imageInfos.push_back(getTexture(resource)->descriptor);
+                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                write.pImageInfo = &imageInfos.back();
+            }
+            writes.push_back(write);
+            writtenPhysicals.push_back(resource.physical);
+        }
+    }
+
+    vkUpdateDescriptorSets(engineDevice.getDevice(), uint32_t(writes.size()), writes.data(), 0, nullptr);
+}
+
+void VulkanComputeGraph::record(VkCommandBuffer commandBuffer) const {
+    assert(isCompiled && "Can't record a graph before it is compiled");
+
+    // Last write of every image and buffer, the stages reading it since and where the write is already visible
+    struct State {
+        VkPipelineStageFlags writeStage = 0;
+        VkAccessFlags writeAccess = 0;
+        VkPipelineStageFlags readStages = 0;
+        VkPipelineStageFlags visibleStages = 0;
+        VkAccessFlags visibleAccess = 0;
+    };
+    std::vector<State> states(physicalCount);
+    for (const ResourceInfo &resource: resources) {
+        if (resource.isSharedBetweenFrames) {
+            states[resource.physical].writeStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            states[resource.physical].writeAccess = VK_ACCESS_SHADER_WRITE_BIT;
+            states[resource.physical].readStages = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        }
+    }
+
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    auto addBarrier = [&](const ResourceInfo &resource, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+        if (resource.buffer != nullptr) {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstAccessMask = dstAccess;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = *resource.buffer->getBuffer();
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            bufferBarriers.push_back(barrier);
+        } else {
+            // Storage images stay in the general layout
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstAccessMask = dstAccess;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = getTexture(resource)->image;
+            barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+            imageBarriers.push_back(barrier);
+        }
+    };
+    auto flushBarriers = [&](VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages) {
+        if (!imageBarriers.empty() || !bufferBarriers.empty()) {
+            vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 0, nullptr,
+                                 uint32_t(bufferBarriers.size()), bufferBarriers.data(),
+                                 uint32_t(imageBarriers.size()), imageBarriers.data());
+            imageBarriers.clear();
+            bufferBarriers.clear();
+        }
+    };
+
+    for (const Entry &entry: entries) {
+        if (entry.commands) {
+            entry.commands(commandBuffer);
+            continue;
+        }
+        if (entry.isCulled) {
+            continue;
+        }
+
+        const Pass &pass = entry.pass;
+        bool isCompute = pass.pipeline != VK_NULL_HANDLE;
+        VkPipelineStageFlags stage = isCompute ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
+        VkAccessFlags readAccess = isCompute ? VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_TRANSFER_READ_BIT;
+        VkAccessFlags writeAccess = isCompute ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        // Accesses of every resource combined over its bindings, aliased images included
+        std::vector<std::pair<const ResourceInfo *, Access>> accesses;
+        for (const Binding &binding: pass.bindings) {
+            if (binding.access == Access::None) {
+                continue;
+            }
+            const ResourceInfo &resource = resources[binding.resource];
+            auto access = std::find_if(accesses.begin(), accesses.end(), [&resource](const auto &other) {
+                return other.first->physical == resource.physical;
+            });
+            if (access == accesses.end()) {
+                accesses.emplace_back(&resource, binding.access);
+            } else if (access->second != binding.access) {
+                access->second = Access::ReadWrite;
+            }
+        }
+
+        VkPipelineStageFlags srcStages = 0;
+        for (const auto &[resource, access]: accesses) {
+            State &state = states[resource->physical];
+            VkPipelineStageFlags src = 0;
+            VkAccessFlags srcAccess = 0, dstAccess = 0;
+
+            // Read after write, unless an earlier barrier already made the write visible here
+            bool isVisible = (state.visibleStages & stage) && (state.visibleAccess & readAccess) == readAccess;
+            if (isRead(access) && state.writeStage != 0 && !isVisible) {
+                src |= state.writeStage;
+                srcAccess |= state.writeAccess;
+                dstAccess |= readAccess;
+            }
+            // Write after read only has to wait for the reads, write after write also for the write
+            if (isWritten(access)) {
+                src |= state.readStages;
+                if (state.writeStage != 0) {
+                    src |= state.writeStage;
+                    srcAccess |= state.writeAccess;
+                    dstAccess |= writeAccess;
+                }
+            }
+
+            if (src != 0) {
+                addBarrier(*resource, srcAccess, dstAccess);
+                srcStages |= src;
+                if (isRead(access) && state.writeStage != 0) {
+                    state.visibleStages |= stage;
+                    state.visibleAccess |= readAccess;
+                }
+            }
+        }
+        flushBarriers(srcStages, stage);
+
+        for (const auto &[resource, access]: accesses) {
+            State &state = states[resource->physical];
+            if (isWritten(access)) {
+                state = State{stage, writeAccess, 0, 0, 0};
+            } else {
+                state.readStages |= stage;
+            }
+        }
+
+        if (isCompute) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pass.pipeline);
+            if (pass.descriptorSet != VK_NULL_HANDLE) {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pass.pipelineLayout, 0, 1,
+                                        &pass.descriptorSet, 0, nullptr);
+            }
+        }
+        pass.record(commandBuffer);
+    }
+
+    // Outputs are made visible to whatever reads them after the graph
+    VkPipelineStageFlags srcStages = 0, dstStages = 0;
+    for (const ResourceInfo &resource: resources) {
+        const State &state = states[resource.physical];
+        if (resource.outputStage != 0 && state.writeStage != 0) {
+            addBarrier(resource, state.writeAccess, resource.outputAccess);
+            srcStages |= state.writeStage;
+            dstStages |= resource.outputStage;
+        }
+    }
+    flushBarriers(srcStages, dstStages);
+}
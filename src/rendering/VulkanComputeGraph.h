@@ -0,0 +1,112 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "VulkanEngineDevice.h"
+#include "VulkanEngineBuffer.h"
+#include "VulkanTexture.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Compute passes of a frame declared with the images and buffers they bind. compile() culls the passes none of the
+// outputs depend on, lets transient images with disjoint lifetimes share one texture and writes the descriptor sets.
+// record() then records the passes with the image and buffer barriers their accesses need.
+class VulkanComputeGraph {
+public:
+    using Resource = uint32_t;
+
+    enum class Access {
+        None, // Bound only because the shader declares it, the pass doesn't touch it
+        Read,
+        Write,
+        ReadWrite,
+    };
+
+    struct Binding {
+        uint32_t binding;
+        Resource resource;
+        Access access;
+        uint32_t arrayElement = 0;
+    };
+
+    struct Pass {
+        std::string name;
+        VkPipeline pipeline = VK_NULL_HANDLE; // Without a pipeline the pass records transfer commands
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE; // Written by compile(), may be shared by passes of a pipeline
+        std::vector<Binding> bindings;
+        std::function<void(VkCommandBuffer)> record; // Push constants and dispatches, the pipeline is already bound
+    };
+
+    explicit VulkanComputeGraph(VulkanEngineDevice &device);
+
+    ~VulkanComputeGraph();
+
+    VulkanComputeGraph(const VulkanComputeGraph &) = delete;
+
+    VulkanComputeGraph &operator=(const VulkanComputeGraph &) = delete;
+
+    // Images and buffers owned elsewhere. Those shared between frames may still be used by the previous submission,
+    // so their first access waits for it.
+    Resource importImage(Texture2D &texture, bool isSharedBetweenFrames = false);
+
+    Resource importBuffer(VulkanEngineBuffer &buffer, bool isSharedBetweenFrames = false);
+
+    // Image only used within the graph, created by compile() unless all passes using it are culled
+    Resource createTransientImage(uint32_t width, uint32_t height, VkFormat format);
+
+    void addPass(Pass pass);
+
+    // Recorded in order between the passes and never culled, e.g. timestamps
+    void addCommands(std::function<void(VkCommandBuffer)> commands);
+
+    // Imported resource read after the graph, its last write is made visible to the given stage and access
+    void markOutput(Resource resource, VkPipelineStageFlags stage, VkAccessFlags access);
+
+    void compile();
+
+    // Recordings don't know about each other, only resources shared between frames wait for earlier submissions
+    void record(VkCommandBuffer commandBuffer) const;
+
+private:
+    struct ResourceInfo {
+        Texture2D *texture = nullptr;
+        VulkanEngineBuffer *buffer = nullptr;
+        bool isTransient = false;
+        bool isSharedBetweenFrames = false;
+        uint32_t width = 0, height = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t physical = 0; // Image or buffer the barriers are tracked for, aliased transient images share it
+        int32_t transientTexture = -1;
+        VkPipelineStageFlags outputStage = 0;
+        VkAccessFlags outputAccess = 0;
+    };
+
+    struct Entry {
+        Pass pass;
+        std::function<void(VkCommandBuffer)> commands; // Set for addCommands() entries, which have no pass
+        bool isCulled = false;
+    };
+
+    static bool isRead(Access access) { return access == Access::Read || access == Access::ReadWrite; }
+
+    static bool isWritten(Access access) { return access == Access::Write || access == Access::ReadWrite; }
+
+    void cullPasses();
+
+    void aliasTransientImages();
+
+    void writeDescriptorSets();
+
+    const Texture2D *getTexture(const ResourceInfo &resource) const;
+
+    VulkanEngineDevice &engineDevice;
+    std::vector<ResourceInfo> resources;
+    std::vector<Entry> entries;
+    std::vector<Texture2D> transientTextures;
+    uint32_t physicalCount = 0;
+    bool isCompiled = false;
+};
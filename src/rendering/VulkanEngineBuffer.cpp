@@ -199,3 +199,65 @@ VkResult VulkanEngineBuffer::invalidateIndex(int index) {
     return invalidate(alignmentSize, index * alignmentSize);
 }
 
+/**
+ * Records a copy of the whole buffer contents from another buffer, the copy is made visible to compute shaders
+ *
+ * @param commandBuffer Command buffer the copy is recorded into
+ * @param srcBuffer Buffer to copy from, usually a host visible staging buffer
+ * @param srcOffset Byte offset of the data in the source buffer
+ * @param (Optional) srcQueueFamily Family of the queue executing the copy, when it differs from dstQueueFamily
+ * the buffer ownership is released to dstQueueFamily and has to be acquired there with recordAcquire
+ * @param (Optional) dstQueueFamily Family of the queue reading the buffer
+ */
+void VulkanEngineBuffer::recordCopyFrom(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkDeviceSize srcOffset,
+                                        uint32_t srcQueueFamily, uint32_t dstQueueFamily) {
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = 0;
+    copyRegion.size = bufferSize;
+    vkCmdCopyBuffer(commandBuffer, srcBuffer, buffer, 1, &copyRegion);
+
+    VkBufferMemoryBarrier bufferMemoryBarrier{};
+    bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferMemoryBarrier.srcQueueFamilyIndex = srcQueueFamily;
+    bufferMemoryBarrier.dstQueueFamilyIndex = dstQueueFamily;
+    bufferMemoryBarrier.buffer = buffer;
+    bufferMemoryBarrier.offset = 0;
+    bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+
+    if (srcQueueFamily != dstQueueFamily) {
+        // Release the ownership, the destination access is defined by the acquire barrier on the other queue
+        bufferMemoryBarrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+        return;
+    }
+
+    bufferMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+}
+
+/**
+ * Acquires the ownership of a buffer filled by recordCopyFrom on a queue of another family
+ *
+ * @param commandBuffer Command buffer of the queue reading the buffer, its submission has to wait on a semaphore
+ * signaled by the copy submission at the compute shader stage
+ * @param srcQueueFamily Family of the queue which executed the copy
+ * @param dstQueueFamily Family of the queue reading the buffer
+ */
+void VulkanEngineBuffer::recordAcquire(VkCommandBuffer commandBuffer, uint32_t srcQueueFamily,
+                                       uint32_t dstQueueFamily) {
+    VkBufferMemoryBarrier bufferMemoryBarrier{};
+    bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcAccessMask = 0;
+    bufferMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    bufferMemoryBarrier.srcQueueFamilyIndex = srcQueueFamily;
+    bufferMemoryBarrier.dstQueueFamilyIndex = dstQueueFamily;
+    bufferMemoryBarrier.buffer = buffer;
+    bufferMemoryBarrier.offset = 0;
+    bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         0, nullptr, 1, &bufferMemoryBarrier, 0, nullptr);
+}
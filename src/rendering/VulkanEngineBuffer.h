@@ -35,6 +35,11 @@ public:
     VkDescriptorBufferInfo descriptorInfoForIndex(int index);
     VkResult invalidateIndex(int index);
 
+    void recordCopyFrom(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkDeviceSize srcOffset,
+                        uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED,
+                        uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED);
+    void recordAcquire(VkCommandBuffer commandBuffer, uint32_t srcQueueFamily, uint32_t dstQueueFamily);
+
     VkBuffer* getBuffer() { return &buffer; }
 
     void *getMappedMemory() const { return mapped; }
@@ -43,7 +48,7 @@ public:
 
     VkDeviceSize getInstanceSize() const { return instanceSize; }
 
-    VkDeviceSize getAlignmentSize() const { return instanceSize; }
+    VkDeviceSize getAlignmentSize() const { return alignmentSize; }
 
     VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
 
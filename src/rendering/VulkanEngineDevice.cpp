@@ -54,6 +54,9 @@ VulkanEngineDevice::VulkanEngineDevice(VulkanEngineWindow &window, const char *t
 VulkanEngineDevice::~VulkanEngineDevice() {
     vkDestroyCommandPool(device_, graphicsCommandPool, nullptr);
     vkDestroyCommandPool(device_, computeCommandPool, nullptr);
+    if (transferCommandPool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(device_, transferCommandPool, nullptr);
+    }
     vkDestroyDevice(device_, nullptr);
 
     if (enableValidationLayers) {
@@ -135,7 +138,10 @@ void VulkanEngineDevice::createLogicalDevice() {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily, indices.computeFamily};
+    if (indices.transferFamilyHasValue) {
+        uniqueQueueFamilies.insert(indices.transferFamily);
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily: uniqueQueueFamilies) {
@@ -147,10 +153,26 @@ void VulkanEngineDevice::createLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_FALSE;
     deviceFeatures.fillModeNonSolid = VK_TRUE;
 
+    // Half float storage images are an extended format, both the shader capability and the format support are optional.
+    // The fallback format always supports storage.
+    VkFormatProperties scalarFormatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, SCALAR_IMAGE_FORMAT, &scalarFormatProperties);
+    if (supportedFeatures.shaderStorageImageExtendedFormats &&
+        (scalarFormatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)) {
+        deviceFeatures.shaderStorageImageExtendedFormats = VK_TRUE;
+        scalarImageFormat = SCALAR_IMAGE_FORMAT;
+    } else {
+        scalarImageFormat = SCALAR_IMAGE_FALLBACK_FORMAT;
+        fmt::print("Scalar storage images fall back to 32 bit floats\n");
+    }
+
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
@@ -174,6 +196,10 @@ void VulkanEngineDevice::createLogicalDevice() {
     vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
     vkGetDeviceQueue(device_, indices.computeFamily, 0, &computeQueue_);
+    if (indices.transferFamilyHasValue) {
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+        fmt::print("Dedicated transfer queue family: {}\n", indices.transferFamily);
+    }
 }
 
 void VulkanEngineDevice::createCommandPool() {
@@ -190,6 +216,14 @@ void VulkanEngineDevice::createCommandPool() {
     cmdPoolInfo.queueFamilyIndex = queueFamilyIndices.computeFamily;
     cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     VK_CHECK(vkCreateCommandPool(device_, &cmdPoolInfo, nullptr, &computeCommandPool));
+
+    if (queueFamilyIndices.transferFamilyHasValue) {
+        VkCommandPoolCreateInfo transferPoolInfo = {};
+        transferPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        transferPoolInfo.queueFamilyIndex = queueFamilyIndices.transferFamily;
+        transferPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        VK_CHECK(vkCreateCommandPool(device_, &transferPoolInfo, nullptr, &transferCommandPool));
+    }
 }
 
 bool VulkanEngineDevice::isDeviceSuitable(VkPhysicalDevice device) {
@@ -366,6 +400,19 @@ QueueFamilyIndices VulkanEngineDevice::findQueueFamilies(VkPhysicalDevice device
         i++;
     }
 
+#if TRANSFER_QUEUE_ENABLED
+    // Transfer only families are not required, they just let uploads run next to the compute work
+    for (uint32_t family = 0; family < queueFamilyCount; family++) {
+        VkQueueFlags flags = queueFamilies[family].queueFlags;
+        if (queueFamilies[family].queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) &&
+            !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            indices.transferFamily = family;
+            indices.transferFamilyHasValue = true;
+            break;
+        }
+    }
+#endif
+
     return indices;
 }
 
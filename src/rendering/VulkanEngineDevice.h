@@ -28,10 +28,12 @@ struct QueueFamilyIndices {
     uint32_t graphicsFamily;
     uint32_t presentFamily;
     uint32_t computeFamily;
+    uint32_t transferFamily; // Family supporting only transfers, usually backed by DMA engines of discrete GPUs
 
     bool graphicsFamilyHasValue = false;
     bool presentFamilyHasValue = false;
     bool computeFamilyHasValue = false;
+    bool transferFamilyHasValue = false;
 
     bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue && computeFamilyHasValue; }
 };
@@ -54,6 +56,7 @@ public:
 
     VkCommandPool getGraphicsCommandPool() { return graphicsCommandPool; }
     VkCommandPool getComputeCommandPool() { return computeCommandPool; }
+    VkCommandPool getTransferCommandPool() { return transferCommandPool; }
 
     VkInstance getInstance() { return instance; }
 
@@ -69,6 +72,13 @@ public:
 
     VkQueue computeQueue() { return computeQueue_; }
 
+    VkQueue transferQueue() { return transferQueue_; }
+
+    bool hasDedicatedTransferQueue() { return transferQueue_ != VK_NULL_HANDLE; }
+
+    // SCALAR_IMAGE_FORMAT if the device supports it as a storage image, SCALAR_IMAGE_FALLBACK_FORMAT otherwise
+    VkFormat getScalarImageFormat() const { return scalarImageFormat; }
+
     SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
 
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -135,12 +145,16 @@ private:
     VulkanEngineWindow &window;
     VkCommandPool graphicsCommandPool;
     VkCommandPool computeCommandPool;
+    VkCommandPool transferCommandPool = VK_NULL_HANDLE;
 
     VkDevice device_;
     VkSurfaceKHR surface_;
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
     VkQueue computeQueue_;
+    VkQueue transferQueue_ = VK_NULL_HANDLE;
+
+    VkFormat scalarImageFormat = SCALAR_IMAGE_FALLBACK_FORMAT;
 
     const std::vector<const char *> validationLayers = {VALIDATION_LAYER_NAME};
 
@@ -0,0 +1,93 @@
+//
+// Created by standa on 16.10.26.
+//
+#include "VulkanEnginePipelineCache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+VulkanEnginePipelineCache::VulkanEnginePipelineCache(VulkanEngineDevice &device) : engineDevice(device) {
+    // Per user cache directory, so the cache doesn't depend on the working directory
+    std::filesystem::path directory;
+    if (const char *cacheHome = std::getenv("XDG_CACHE_HOME")) {
+        directory = cacheHome;
+    } else if (const char *home = std::getenv("HOME")) {
+        directory = std::filesystem::path(home) / ".cache";
+    } else {
+        directory = std::filesystem::temp_directory_path();
+    }
+    directory /= PIPELINE_CACHE_DIRECTORY;
+
+    std::string uuid;
+    for (uint8_t byte: engineDevice.properties.pipelineCacheUUID) {
+        uuid += fmt::format("{:02x}", byte);
+    }
+    cachePath = (directory / fmt::format("pipelines_{}_{}.bin", uuid, engineDevice.properties.driverVersion)).string();
+
+    std::vector<char> data;
+    std::ifstream file(cachePath, std::ios::binary);
+    if (file.is_open()) {
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (!isCompatible(data)) {
+            fmt::print("Ignoring incompatible pipeline cache {}\n", cachePath);
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+    VK_CHECK(vkCreatePipelineCache(engineDevice.getDevice(), &createInfo, nullptr, &pipelineCache));
+}
+
+VulkanEnginePipelineCache::~VulkanEnginePipelineCache() {
+    save();
+    vkDestroyPipelineCache(engineDevice.getDevice(), pipelineCache, nullptr);
+}
+
+// The header is checked as well, the file name alone doesn't protect against a truncated or foreign file
+bool VulkanEnginePipelineCache::isCompatible(const std::vector<char> &data) const {
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == engineDevice.properties.vendorID &&
+           header.deviceID == engineDevice.properties.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, engineDevice.properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void VulkanEnginePipelineCache::save() const {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(engineDevice.getDevice(), pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) {
+        return;
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(engineDevice.getDevice(), pipelineCache, &size, data.data()) != VK_SUCCESS) {
+        return;
+    }
+
+    // Written next to the cache and renamed, a concurrently starting instance never reads a partial file
+    std::error_code error;
+    std::filesystem::path path(cachePath);
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), std::streamsize(size))) {
+            fmt::print("Failed to write pipeline cache {}\n", cachePath);
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        fmt::print("Failed to write pipeline cache {}\n", cachePath);
+    }
+}
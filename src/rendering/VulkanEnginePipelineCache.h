@@ -0,0 +1,34 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "VulkanEngineDevice.h"
+
+#include <string>
+#include <vector>
+
+// Pipeline cache shared by every pipeline of the engine and persisted between runs. The file is keyed by the
+// pipeline cache UUID and driver version of the device, so data of another device or driver is never loaded.
+class VulkanEnginePipelineCache {
+public:
+    explicit VulkanEnginePipelineCache(VulkanEngineDevice &device);
+
+    ~VulkanEnginePipelineCache();
+
+    VulkanEnginePipelineCache(const VulkanEnginePipelineCache &) = delete;
+
+    VulkanEnginePipelineCache &operator=(const VulkanEnginePipelineCache &) = delete;
+
+    VkPipelineCache getPipelineCache() const { return pipelineCache; }
+
+    // Writes the current cache data to disk, failures only cost the next start its warm cache
+    void save() const;
+
+private:
+    bool isCompatible(const std::vector<char> &data) const;
+
+    VulkanEngineDevice &engineDevice;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    std::string cachePath;
+};
@@ -34,6 +34,7 @@ CommandBufferPair VulkanEngineRenderer::beginFrame() {
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
+    auto computeCommandBuffer = getCurrentComputeCommandBuffer();
     VK_CHECK(vkBeginCommandBuffer(computeCommandBuffer, &beginInfo));
 
     // Begin graphics command buffer
@@ -47,6 +48,7 @@ CommandBufferPair VulkanEngineRenderer::beginFrame() {
 void VulkanEngineRenderer::endFrame(Dataset *dataset) {
     assert(isFrameStarted && "Can't call endFrame while frame is not in progress!");
     auto commandBuffer = getCurrentGraphicsCommandBuffer();
+    auto computeCommandBuffer = getCurrentComputeCommandBuffer();
 
     VK_CHECK(vkEndCommandBuffer(computeCommandBuffer));
     VK_CHECK(vkEndCommandBuffer(commandBuffer));
@@ -70,6 +72,26 @@ void VulkanEngineRenderer::endFrame(Dataset *dataset) {
     currentFrameIndex = (currentFrameIndex + 1) % VulkanEngineSwapChain::MAX_FRAMES_IN_FLIGHT;
 }
 
+VkCommandBuffer VulkanEngineRenderer::beginTransfer() {
+    assert(isFrameStarted && "Can't call beginTransfer if frame is not in progress!");
+    assert(!transferCommandBuffers.empty() && "Device has no dedicated transfer queue");
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VK_CHECK(vkBeginCommandBuffer(transferCommandBuffers[currentFrameIndex], &beginInfo));
+    return transferCommandBuffers[currentFrameIndex];
+}
+
+// Submitted right away, so the transfer runs while the rest of the frame is being recorded
+void VulkanEngineRenderer::submitTransfer() {
+    assert(isFrameStarted && "Can't call submitTransfer if frame is not in progress!");
+
+    VK_CHECK(vkEndCommandBuffer(transferCommandBuffers[currentFrameIndex]));
+    engineSwapChain->submitTransferCommandBuffer(&transferCommandBuffers[currentFrameIndex]);
+}
+
 void VulkanEngineRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkImage &outputImage) {
     assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress!");
     assert(commandBuffer == getCurrentGraphicsCommandBuffer() &&
@@ -132,18 +154,43 @@ void VulkanEngineRenderer::createCommandBuffers() {
 
     VK_CHECK(vkAllocateCommandBuffers(engineDevice.getDevice(), &allocInfo, graphicsCommandBuffers.data()));
 
-    // Create a command buffer for compute operations
+    // Create a command buffer for compute operations of every frame in flight
+    computeCommandBuffers.resize(VulkanEngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+
     VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
     commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     commandBufferAllocateInfo.commandPool = engineDevice.getComputeCommandPool();
     commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    commandBufferAllocateInfo.commandBufferCount = 1;
+    commandBufferAllocateInfo.commandBufferCount = static_cast<uint32_t>(computeCommandBuffers.size());
+
+    VK_CHECK(vkAllocateCommandBuffers(engineDevice.getDevice(), &commandBufferAllocateInfo,
+                                      computeCommandBuffers.data()));
+
+    if (engineDevice.hasDedicatedTransferQueue()) {
+        transferCommandBuffers.resize(VulkanEngineSwapChain::MAX_FRAMES_IN_FLIGHT);
 
-    VK_CHECK(vkAllocateCommandBuffers(engineDevice.getDevice(), &commandBufferAllocateInfo, &computeCommandBuffer));
+        commandBufferAllocateInfo.commandPool = engineDevice.getTransferCommandPool();
+        commandBufferAllocateInfo.commandBufferCount = static_cast<uint32_t>(transferCommandBuffers.size());
+
+        VK_CHECK(vkAllocateCommandBuffers(engineDevice.getDevice(), &commandBufferAllocateInfo,
+                                          transferCommandBuffers.data()));
+    }
 }
 
 void VulkanEngineRenderer::freeCommandBuffers() {
+    vkDeviceWaitIdle(engineDevice.getDevice());
 
+    vkFreeCommandBuffers(engineDevice.getDevice(), engineDevice.getGraphicsCommandPool(),
+                         static_cast<uint32_t>(graphicsCommandBuffers.size()), graphicsCommandBuffers.data());
+    vkFreeCommandBuffers(engineDevice.getDevice(), engineDevice.getComputeCommandPool(),
+                         static_cast<uint32_t>(computeCommandBuffers.size()), computeCommandBuffers.data());
+    if (!transferCommandBuffers.empty()) {
+        vkFreeCommandBuffers(engineDevice.getDevice(), engineDevice.getTransferCommandPool(),
+                             static_cast<uint32_t>(transferCommandBuffers.size()), transferCommandBuffers.data());
+    }
+    graphicsCommandBuffers.clear();
+    computeCommandBuffers.clear();
+    transferCommandBuffers.clear();
 }
 
 void VulkanEngineRenderer::recreateSwapChain() {
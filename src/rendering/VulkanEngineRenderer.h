@@ -37,7 +37,10 @@ public:
         return graphicsCommandBuffers[currentFrameIndex];
     }
 
-    VkCommandBuffer getComputeCommandBuffer() const { return computeCommandBuffer; }
+    VkCommandBuffer getCurrentComputeCommandBuffer() const {
+        assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
+        return computeCommandBuffers[currentFrameIndex];
+    }
 
     VulkanEngineSwapChain *getEngineSwapChain() const { return engineSwapChain.get(); }
 
@@ -48,6 +51,10 @@ public:
 
     CommandBufferPair beginFrame();
     void endFrame(Dataset *dataset);
+
+    // Transfer commands of the current frame, only available with a dedicated transfer queue
+    VkCommandBuffer beginTransfer();
+    void submitTransfer();
     void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkImage &outputImage);
     void endSwapChainRenderPass(VkCommandBuffer graphicsCommandBuffer);
 
@@ -60,7 +67,8 @@ private:
     VulkanEngineDevice &engineDevice;
     std::unique_ptr<VulkanEngineSwapChain> engineSwapChain;
     std::vector<VkCommandBuffer> graphicsCommandBuffers;
-    VkCommandBuffer computeCommandBuffer;
+    std::vector<VkCommandBuffer> computeCommandBuffers;
+    std::vector<VkCommandBuffer> transferCommandBuffers;
 
     VkImage currentImage;
 
@@ -4,6 +4,8 @@
 
 #include "VulkanEngineSwapChain.h"
 
+#include <cassert>
+
 VulkanEngineSwapChain::VulkanEngineSwapChain(VulkanEngineDevice &engineDevice, VkExtent2D extent) : engineDevice{
         engineDevice}, windowExtent{extent} {
     init();
@@ -53,10 +55,10 @@ VulkanEngineSwapChain::~VulkanEngineSwapChain() {
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vkDestroySemaphore(engineDevice.getDevice(), renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(engineDevice.getDevice(), imageAvailableSemaphores[i], nullptr);
+        vkDestroySemaphore(engineDevice.getDevice(), computeFinishedSemaphores[i], nullptr);
+        vkDestroySemaphore(engineDevice.getDevice(), transferFinishedSemaphores[i], nullptr);
         vkDestroyFence(engineDevice.getDevice(), inFlightFences[i], nullptr);
     }
-
-    vkDestroySemaphore(engineDevice.getDevice(), computeSemaphore, nullptr);
 }
 
 VkFormat VulkanEngineSwapChain::findDepthFormat() {
@@ -95,27 +97,31 @@ VulkanEngineSwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, cons
     }
     imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
-    // Wait for rendering finished
-    VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    // Wait for rendering finished and for the upload of the input image
+    VkPipelineStageFlags computeWaitStageMasks[] = {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+    VkSemaphore computeWaitSemaphores[] = {imageAvailableSemaphores[currentFrame],
+                                           transferFinishedSemaphores[currentFrame]};
 
     VkSubmitInfo computeSubmitInfo = {};
     computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
     computeSubmitInfo.commandBufferCount = 1;
     computeSubmitInfo.pCommandBuffers = computeCommandBuffer;
-    computeSubmitInfo.waitSemaphoreCount = 1;
-    computeSubmitInfo.pWaitSemaphores = &imageAvailableSemaphores[currentFrame];
-    computeSubmitInfo.pWaitDstStageMask = &waitStageMask;
+    computeSubmitInfo.waitSemaphoreCount = isTransferSubmitted ? 2 : 1;
+    computeSubmitInfo.pWaitSemaphores = computeWaitSemaphores;
+    computeSubmitInfo.pWaitDstStageMask = computeWaitStageMasks;
     computeSubmitInfo.signalSemaphoreCount = 1;
-    computeSubmitInfo.pSignalSemaphores = &computeSemaphore;
+    computeSubmitInfo.pSignalSemaphores = &computeFinishedSemaphores[currentFrame];
 
     if (vkQueueSubmit(engineDevice.computeQueue(), 1, &computeSubmitInfo, VK_NULL_HANDLE)) {
         throw std::runtime_error("Failed to submit compute queue!");
     }
+    isTransferSubmitted = false;
 
     VkPipelineStageFlags graphicsWaitStageMasks[] = {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
                                                      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    VkSemaphore graphicsWaitSemaphores[] = {computeSemaphore};
+    VkSemaphore graphicsWaitSemaphores[] = {computeFinishedSemaphores[currentFrame]};
     VkSemaphore graphicsSignalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
 
     // Submit graphics commands
@@ -154,6 +160,26 @@ VulkanEngineSwapChain::submitCommandBuffers(const VkCommandBuffer *buffers, cons
     return result;
 }
 
+/**
+ * Submits transfer commands of the current frame to the dedicated transfer queue. The frame's compute commands
+ * submitted by the following submitCommandBuffers() wait for them, so the transfer overlaps the previous frames.
+ */
+void VulkanEngineSwapChain::submitTransferCommandBuffer(const VkCommandBuffer *transferCommandBuffer) {
+    assert(engineDevice.hasDedicatedTransferQueue() && "Device has no dedicated transfer queue");
+
+    VkSubmitInfo transferSubmitInfo = {};
+    transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transferSubmitInfo.commandBufferCount = 1;
+    transferSubmitInfo.pCommandBuffers = transferCommandBuffer;
+    transferSubmitInfo.signalSemaphoreCount = 1;
+    transferSubmitInfo.pSignalSemaphores = &transferFinishedSemaphores[currentFrame];
+
+    if (vkQueueSubmit(engineDevice.transferQueue(), 1, &transferSubmitInfo, VK_NULL_HANDLE)) {
+        throw std::runtime_error("Failed to submit transfer queue!");
+    }
+    isTransferSubmitted = true;
+}
+
 void VulkanEngineSwapChain::createSwapChain() {
     SwapChainSupportDetails swapChainSupport = engineDevice.getSwapChainSupport();
 
@@ -356,6 +382,8 @@ void VulkanEngineSwapChain::createFrameBuffers() {
 void VulkanEngineSwapChain::createSyncObjects() {
     imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+    computeFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+    transferFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
     imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
@@ -369,10 +397,10 @@ void VulkanEngineSwapChain::createSyncObjects() {
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         VK_CHECK(vkCreateSemaphore(engineDevice.getDevice(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]));
         VK_CHECK(vkCreateSemaphore(engineDevice.getDevice(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]));
+        VK_CHECK(vkCreateSemaphore(engineDevice.getDevice(), &semaphoreInfo, nullptr, &computeFinishedSemaphores[i]));
+        VK_CHECK(vkCreateSemaphore(engineDevice.getDevice(), &semaphoreInfo, nullptr, &transferFinishedSemaphores[i]));
         VK_CHECK(vkCreateFence(engineDevice.getDevice(), &fenceInfo, nullptr, &inFlightFences[i]));
     }
-
-    VK_CHECK(vkCreateSemaphore(engineDevice.getDevice(), &semaphoreInfo, nullptr, &computeSemaphore));
 }
 
 VkSurfaceFormatKHR
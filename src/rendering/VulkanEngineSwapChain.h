@@ -51,6 +51,7 @@ public:
     VkFormat findDepthFormat();
     VkResult acquireNextImage(uint32_t *imageIndex);
     VkResult submitCommandBuffers(const VkCommandBuffer *buffers, const VkCommandBuffer *computeCommandBuffer, const uint32_t *imageIndex);
+    void submitTransferCommandBuffer(const VkCommandBuffer *transferCommandBuffer);
 
     bool compareSwapFormats(const VulkanEngineSwapChain &swapChain) const {
         return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -91,7 +92,9 @@ private:
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
-    VkSemaphore computeSemaphore;
+    std::vector<VkSemaphore> computeFinishedSemaphores;
+    std::vector<VkSemaphore> transferFinishedSemaphores;
+    bool isTransferSubmitted = false; // Compute commands of the current frame wait for the transfer
 
     std::vector<VkFence> inFlightFences;
     std::vector<VkFence> imagesInFlight;
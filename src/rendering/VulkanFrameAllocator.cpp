@@ -0,0 +1,102 @@
+//
+// Created by standa on 16.10.26.
+//
+#include "VulkanFrameAllocator.h"
+
+#include <algorithm>
+
+VulkanFrameAllocator::VulkanFrameAllocator(VulkanEngineDevice &device) : engineDevice(device) {
+    // Frames are read by the CPU algorithms as well, uncached memory would make those reads very slow
+    VkMemoryPropertyFlags cachedFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                                        VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+    memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(engineDevice.getPhysicalDevice(), &memoryProperties);
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((memoryProperties.memoryTypes[i].propertyFlags & cachedFlags) == cachedFlags) {
+            memoryPropertyFlags = cachedFlags;
+            break;
+        }
+    }
+}
+
+VulkanFrameAllocator::~VulkanFrameAllocator() {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBuffers.clear();
+}
+
+cv::UMatData *VulkanFrameAllocator::allocate(int dims, const int *sizes, int type, void *data0, size_t *step,
+                                             cv::AccessFlag, cv::UMatUsageFlags) const {
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data0 && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    auto *data = new cv::UMatData(this);
+    data->size = total;
+    if (data0) {
+        data->data = data->origdata = static_cast<uchar *>(data0);
+        data->flags |= cv::UMatData::USER_ALLOCATED;
+        return data;
+    }
+
+    // Rounded up to whole words, so GPU copies of the padded frame size stay inside the buffer
+    VkDeviceSize bufferSize = (VkDeviceSize(total) + 3) & ~VkDeviceSize(3);
+
+    std::unique_ptr<VulkanEngineBuffer> buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find_if(freeBuffers.begin(), freeBuffers.end(), [&](const auto &freeBuffer) {
+            return freeBuffer->getBufferSize() == bufferSize;
+        });
+        if (it != freeBuffers.end()) {
+            buffer = std::move(*it);
+            freeBuffers.erase(it);
+        } else {
+            // Frame size has changed, the old buffers won't be needed anymore
+            freeBuffers.clear();
+        }
+    }
+
+    if (buffer == nullptr) {
+        buffer = std::make_unique<VulkanEngineBuffer>(engineDevice, bufferSize, 1,
+                                                      VK_BUFFER_USAGE_TRANSFER_SRC_BIT, memoryPropertyFlags);
+        VK_CHECK(buffer->map());
+    }
+
+    data->data = data->origdata = static_cast<uchar *>(buffer->getMappedMemory());
+    data->handle = buffer.release();
+    return data;
+}
+
+bool VulkanFrameAllocator::allocate(cv::UMatData *data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void VulkanFrameAllocator::deallocate(cv::UMatData *data) const {
+    if (data == nullptr) return;
+
+    CV_Assert(data->urefcount == 0);
+    CV_Assert(data->refcount == 0);
+    if (!(data->flags & cv::UMatData::USER_ALLOCATED)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBuffers.emplace_back(static_cast<VulkanEngineBuffer *>(data->handle));
+    }
+    delete data;
+}
+
+VulkanEngineBuffer *VulkanFrameAllocator::findBuffer(const cv::Mat &mat) const {
+    if (mat.u == nullptr || mat.u->currAllocator != this || (mat.u->flags & cv::UMatData::USER_ALLOCATED)) {
+        return nullptr;
+    }
+    return static_cast<VulkanEngineBuffer *>(mat.u->handle);
+}
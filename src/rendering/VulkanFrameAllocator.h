@@ -0,0 +1,43 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "VulkanEngineDevice.h"
+#include "VulkanEngineBuffer.h"
+#include "opencv4/opencv2/opencv.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// OpenCV allocator placing Mat data into persistently mapped host visible Vulkan buffers. Frames decoded into such
+// Mats are read by the CPU algorithms and copied to the GPU straight from the same memory, without a staging copy.
+// Buffers of released Mats are kept for the following frames, so decoding doesn't allocate device memory.
+class VulkanFrameAllocator : public cv::MatAllocator {
+public:
+    explicit VulkanFrameAllocator(VulkanEngineDevice &device);
+
+    ~VulkanFrameAllocator() override;
+
+    VulkanFrameAllocator(const VulkanFrameAllocator &) = delete;
+
+    VulkanFrameAllocator &operator=(const VulkanFrameAllocator &) = delete;
+
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data0, size_t *step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usageFlags) const override;
+
+    bool allocate(cv::UMatData *data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+
+    void deallocate(cv::UMatData *data) const override;
+
+    // Buffer holding the data of the Mat, nullptr when the Mat was not allocated by this allocator
+    VulkanEngineBuffer *findBuffer(const cv::Mat &mat) const;
+
+private:
+    VulkanEngineDevice &engineDevice;
+    VkMemoryPropertyFlags memoryPropertyFlags;
+
+    mutable std::mutex mutex;
+    mutable std::vector<std::unique_ptr<VulkanEngineBuffer>> freeBuffers;
+};
@@ -19,6 +19,10 @@ void Texture::updateDescriptor() {
 void Texture::destroy(VulkanEngineDevice &device) {
     vkDestroyImageView(device.getDevice(), view, nullptr);
     view = nullptr;
+    if (displayView) {
+        vkDestroyImageView(device.getDevice(), displayView, nullptr);
+        displayView = nullptr;
+    }
     vkDestroyImage(device.getDevice(), image, nullptr);
     image = nullptr;
     if (sampler) {
@@ -207,25 +211,38 @@ Texture2D::fromImageFile(void *buffer, VkDeviceSize bufferSize, VkFormat format,
     updateDescriptor();
 }
 
-void Texture2D::createTextureTarget(VulkanEngineDevice &engineDevice, Texture2D inputTexture) {
+void Texture2D::createTextureTarget(VulkanEngineDevice &engineDevice, Texture2D inputTexture, VkFormat format) {
+    createTextureTarget(engineDevice, inputTexture.width, inputTexture.height, format);
+}
+
+/**
+* Creates a storage image in general layout which can also be sampled
+*
+* @param engineDevice Vulkan device to create the texture on
+* @param texWidth Width of the texture to create
+* @param texHeight Height of the texture to create
+* @param format Format of the texture, must support storage image operations
+*/
+void Texture2D::createTextureTarget(VulkanEngineDevice &engineDevice, uint32_t texWidth, uint32_t texHeight,
+                                    VkFormat format) {
     VkFormatProperties formatProperties;
 
     // Get device properties for the requested texture format
-    vkGetPhysicalDeviceFormatProperties(engineDevice.getPhysicalDevice(), VK_FORMAT_R8G8B8A8_UNORM, &formatProperties);
+    vkGetPhysicalDeviceFormatProperties(engineDevice.getPhysicalDevice(), format, &formatProperties);
     // Check if requested image format supports image storage operations
     assert(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
 
     // Prepare blit target texture
-    width = inputTexture.width;
-    height = inputTexture.height;
+    width = texWidth;
+    height = texHeight;
     mipLevels = 1;
 
     VkImageCreateInfo imageCreateInfo{};
     imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageCreateInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-    imageCreateInfo.extent.width = inputTexture.width;
-    imageCreateInfo.extent.height = inputTexture.height;
+    imageCreateInfo.format = format;
+    imageCreateInfo.extent.width = width;
+    imageCreateInfo.extent.height = height;
     imageCreateInfo.extent.depth = 1;
     imageCreateInfo.mipLevels = 1;
     imageCreateInfo.arrayLayers = 1;
@@ -267,12 +284,14 @@ void Texture2D::createTextureTarget(VulkanEngineDevice &engineDevice, Texture2D
 
     engineDevice.endSingleTimeCommands(layoutCmd, engineDevice.graphicsQueue());
 
-    // Create sampler
+    // Create sampler, linear filtering is optional for some formats such as the 32 bit float scalar fallback
+    VkFilter filter = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+                      ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
     VkSamplerCreateInfo sampler{};
     sampler.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    sampler.magFilter = VK_FILTER_LINEAR;
-    sampler.minFilter = VK_FILTER_LINEAR;
-    sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sampler.magFilter = filter;
+    sampler.minFilter = filter;
+    sampler.mipmapMode = filter == VK_FILTER_LINEAR ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
     sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
     sampler.addressModeV = sampler.addressModeU;
     sampler.addressModeW = sampler.addressModeU;
@@ -289,9 +308,10 @@ void Texture2D::createTextureTarget(VulkanEngineDevice &engineDevice, Texture2D
     view.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     view.image = VK_NULL_HANDLE;
     view.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    view.format = VK_FORMAT_R8G8B8A8_UNORM;
+    view.format = format;
+    // Storage image views must not be swizzled
     view.components = {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B,
-                       VK_COMPONENT_SWIZZLE_A}; // Here it doesn't matter rn as the output is usually BW
+                       VK_COMPONENT_SWIZZLE_A};
     view.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
     view.image = image;
     VK_CHECK(vkCreateImageView(engineDevice.getDevice(), &view, nullptr, &this->view));
@@ -300,4 +320,13 @@ void Texture2D::createTextureTarget(VulkanEngineDevice &engineDevice, Texture2D
     descriptor.imageLayout = imageLayout;
     descriptor.imageView = this->view;
     descriptor.sampler = this->sampler;
-}
\ No newline at end of file
+
+    // Single channel images are displayed as grey
+    displayDescriptor = descriptor;
+    if (format == VK_FORMAT_R8_UNORM || format == VK_FORMAT_R16_SFLOAT || format == VK_FORMAT_R32_SFLOAT) {
+        view.components = {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R,
+                           VK_COMPONENT_SWIZZLE_ONE};
+        VK_CHECK(vkCreateImageView(engineDevice.getDevice(), &view, nullptr, &displayView));
+        displayDescriptor.imageView = displayView;
+    }
+}
@@ -29,6 +29,9 @@ class Texture
 	uint32_t              layerCount;
 	VkDescriptorImageInfo descriptor;
 	VkSampler             sampler;
+	// Sampled by the debug views, single channel targets are swizzled to grey as storage views can't be
+	VkImageView           displayView = VK_NULL_HANDLE;
+	VkDescriptorImageInfo displayDescriptor;
 
 	void      updateDescriptor();
 	void      destroy(VulkanEngineDevice &device);
@@ -49,5 +52,9 @@ class Texture2D : public Texture
 	    VkImageUsageFlags  imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 	    VkImageLayout      imageLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-    void createTextureTarget(VulkanEngineDevice &engineDevice, Texture2D inputTexture);
+    void createTextureTarget(VulkanEngineDevice &engineDevice, Texture2D inputTexture,
+                             VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+
+    void createTextureTarget(VulkanEngineDevice &engineDevice, uint32_t texWidth, uint32_t texHeight,
+                             VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
 };
\ No newline at end of file
@@ -1,7 +1,8 @@
 #include "DebugGui.h"
 #include <numeric>
 
-DebugGui::DebugGui(VulkanEngineDevice &engineDevice, VulkanEngineRenderer &renderer, SDL_Window *window) {
+DebugGui::DebugGui(VulkanEngineDevice &engineDevice, VulkanEngineRenderer &renderer, SDL_Window *window,
+                   VkPipelineCache pipelineCache) {
     imguiPool = VulkanEngineDescriptorPool::Builder(engineDevice)
             .setMaxSets(1000)
             .addPoolSize(VK_DESCRIPTOR_TYPE_SAMPLER, 1000)
@@ -33,7 +34,7 @@ DebugGui::DebugGui(VulkanEngineDevice &engineDevice, VulkanEngineRenderer &rende
     init_info.Device = engineDevice.getDevice();
     init_info.QueueFamily = engineDevice.findPhysicalQueueFamilies().graphicsFamily;
     init_info.Queue = engineDevice.graphicsQueue();
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = pipelineCache;
     init_info.DescriptorPool = imguiPool->getPool();
     init_info.Subpass = 0;
     init_info.MinImageCount = VulkanEngineSwapChain::MAX_FRAMES_IN_FLIGHT;
@@ -80,14 +81,44 @@ void DebugGui::showGraphs(long frameIndex, Dataset *dataset) {
 
     ImGui::Checkbox("Show vanishing point", &dataset->showVanishingPoint);
     ImGui::Checkbox("Show keypoints", &dataset->showKeypoints);
+    ImGui::Checkbox("Fused dehaze kernel", &dataset->useFusedDehaze);
+    ImGui::Checkbox("Airlight from top 0.1 % of dark channel", &dataset->useTopDarkChannelAirLight);
+    ImGui::SliderInt("Dark channel radius", &dataset->darkChannelRadius, 1, DARK_CHANNEL_MAX_RADIUS);
+    ImGui::SliderInt("Guided filter radius", &dataset->guidedFilterRadius, 1, GUIDED_FILTER_MAX_RADIUS);
+    ImGui::SliderFloat("Guided filter epsilon", &dataset->guidedFilterEpsilon, 0.000001f, 0.1f, "%.6f",
+                       ImGuiSliderFlags_Logarithmic);
+
+    // Scrub bar, the seek is requested only once the slider is released
+    if (!isScrubbing) scrubFrame = int(frameIndex);
+    ImGui::SliderInt("Frame", &scrubFrame, 0, std::max(int(dataset->totalFrames) - 1, 0));
+    isScrubbing = ImGui::IsItemActive();
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        dataset->seekFrameIndex = scrubFrame;
+    }
+
+    // Older history is drawn from the min/max/mean buckets, the recent window at full resolution
+    const TimeSeriesStore &visibility = dataset->vp_visibility;
+    std::vector<TimeSeriesStore::Bucket> buckets = visibility.getBuckets();
+    std::vector<double> x, y, yMin, yMax;
+    x.reserve(buckets.size() + visibility.getRecentSize());
+    y.reserve(buckets.size() + visibility.getRecentSize());
+    for (const auto &bucket: buckets) {
+        x.push_back(double(bucket.firstIndex) + double(bucket.count) / 2.0);
+        y.push_back(bucket.mean());
+        yMin.push_back(bucket.min);
+        yMax.push_back(bucket.max);
+    }
+    for (size_t i = 0; i < visibility.getRecentSize(); i++) {
+        x.push_back(double(visibility.getRecentFirstIndex() + i));
+        y.push_back(visibility.recentAt(i));
+    }
 
-    std::vector<double> x(frameIndex);
-    std::iota(std::begin(x), std::end(x), 0);
     if (ImPlot::BeginPlot("##Visibility (FFT)")) {
         ImPlot::SetupAxis(ImAxis_X1, "Frame", ImPlotAxisFlags_AutoFit);
         ImPlot::SetupAxis(ImAxis_Y1, "Visibility (FFT)", ImPlotAxisFlags_AutoFit);
 
-        ImPlot::PlotLine("", x.data(), dataset->vp_visibility.data(), int(frameIndex), ImPlotLineFlags_NoClip);
+        ImPlot::PlotShaded("##Range", x.data(), yMin.data(), yMax.data(), int(yMin.size()));
+        ImPlot::PlotLine("", x.data(), y.data(), int(x.size()), ImPlotLineFlags_NoClip);
         ImPlot::EndPlot();
     }
 
@@ -151,6 +182,12 @@ void DebugGui::showStats(long frameIndex, Dataset *dataset) {
     ImGui::TextColored(ImVec4(1, 0, 0, 1), "FPS: %f", movingFPSAverage);
     lastFrameTimestamp = ImGui::GetTime();
 
+    // Frame prefetching
+    ImGui::TextColored(ImVec4(1, 0, 0, 1), "Prefetch stalls: %u (last wait %f ms)", dataset->prefetchStalls,
+                       dataset->prefetchWait);
+    ImGui::TextColored(ImVec4(1, 0, 0, 1), "Thermal frame: %u (sync error %ld)", dataset->thermalFrameIndex,
+                       dataset->thermalSyncError);
+
     static const char *labelIds[] = {"CameraFrameExtraction", "GlareAndOcclusion Detection", "VanishingPointEstimation",
                                      "VanishingPointVisibilityCalculation", "FogDetection",
                                      "TextureGeneration", "FrameSubmission", "Rendering"};
@@ -180,6 +217,26 @@ void DebugGui::showStats(long frameIndex, Dataset *dataset) {
         ImPlot::EndPlot();
     }
 
+    // GPU stages in milliseconds, as measured by the timestamp queries
+    static const char *gpuLabelIds[] = {"Unpack", "DarkChannel", "AirLight", "Transmission", "GuidedFilter",
+                                        "Radiance", "Graphics"};
+    float gpuValues[] = {dataset->gpuUnpack, dataset->gpuDarkChannel, dataset->gpuAirLight,
+                         dataset->gpuTransmission, dataset->gpuGuidedFilter, dataset->gpuRadiance,
+                         dataset->gpuGraphics};
+    float gpuSum = 0.0f;
+    for (const auto &val: gpuValues) {
+        gpuSum += val;
+    }
+    ImGui::TextColored(ImVec4(1, 0, 0, 1), "GPU time: %f ms", gpuSum);
+
+    if (gpuSum > 0.0f && ImPlot::BeginPlot("##GpuTiming")) {
+        static int axesFlags = ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoGridLines | ImPlotAxisFlags_NoTickMarks |
+                               ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickLabels;
+        ImPlot::SetupAxes(nullptr, nullptr, axesFlags, axesFlags);
+        ImPlot::PlotPieChart(gpuLabelIds, gpuValues, 7, 0.5, 0.5, 0.4, "%.2f", 90, ImPlotPieChartFlags_Normalize);
+        ImPlot::EndPlot();
+    }
+
     ImGui::End();
 }
 
@@ -20,7 +20,8 @@
 
 class DebugGui {
 public:
-    DebugGui(VulkanEngineDevice &engineDevice, VulkanEngineRenderer &renderer, SDL_Window *window);
+    DebugGui(VulkanEngineDevice &engineDevice, VulkanEngineRenderer &renderer, SDL_Window *window,
+             VkPipelineCache pipelineCache);
 
     ~DebugGui();
 
@@ -44,5 +45,8 @@ private:
     double lastFrameTimestamp = 0;
     double movingFPSAverage = 0;
 
+    int scrubFrame = 0;
+    bool isScrubbing = false;
+
     std::unique_ptr<VulkanEngineDescriptorPool> imguiPool{};
 };
\ No newline at end of file
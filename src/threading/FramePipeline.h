@@ -0,0 +1,197 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "../GlobalConfiguration.h"
+#include "../util/Dataset.h"
+#include "../algorithms/DatasetFileReader.h"
+#include "../algorithms/CameraAlgorithms.h"
+#include "BS_thread_pool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Runs the frame loop as a three stage pipeline over a small pool of Dataset slots. While the main thread renders
+// frame N, the analysis thread runs the CPU algorithms on frame N+1 and the decode thread reads frame N+2.
+// Every slot is owned by exactly one stage at a time and is handed to the next one through an ordered queue.
+// The history series and occlusion buffers live in the history Dataset, which only the analysis thread touches
+// while the pipeline runs. They are swapped into a slot for its analysis and back out of it afterwards, and only
+// the visibility series shown by the GUI is copied into the slot, so the per-frame cost doesn't grow with the state.
+class FramePipeline {
+public:
+    FramePipeline(DatasetFileReader &_reader, Dataset *_history, BS::thread_pool &_pool,
+                  size_t slotCount = FRAME_PIPELINE_SLOTS) : reader(_reader), history(_history), pool(_pool) {
+        for (size_t i = 0; i < std::max<size_t>(slotCount, 3); i++) {
+            slots.emplace_back(std::make_unique<Dataset>());
+            slots.back()->totalFrames = history->totalFrames;
+            slots.back()->cameraWidth = history->cameraWidth;
+            slots.back()->cameraHeight = history->cameraHeight;
+        }
+    }
+
+    ~FramePipeline() { stop(); }
+
+    FramePipeline(const FramePipeline &) = delete;
+
+    FramePipeline &operator=(const FramePipeline &) = delete;
+
+    // Starts decoding and analysis from firstFrame, the decoders must already be positioned on it
+    void start(uint32_t firstFrame) {
+        stop();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeSlots.clear();
+            decodedSlots.clear();
+            analysedSlots.clear();
+            for (auto &slot: slots) {
+                if (slot.get() != displayed) freeSlots.push_back(slot.get());
+            }
+            isRunning = true;
+        }
+
+        decoder = std::thread(&FramePipeline::decode, this, firstFrame);
+        analyser = std::thread(&FramePipeline::analyse, this);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isRunning = false;
+        }
+        condition.notify_all();
+
+        if (decoder.joinable()) decoder.join();
+        if (analyser.joinable()) analyser.join();
+    }
+
+    // Repositions the decoders and restarts the pipeline, false if the frame is out of the session
+    bool seek(uint32_t frameIndex) {
+        if (frameIndex >= history->totalFrames) return false;
+
+        stop();
+        reader.seekStreams(frameIndex);
+        start(frameIndex);
+        return true;
+    }
+
+    bool isStarted() const { return decoder.joinable(); }
+
+    // Returns the next analysed frame in order and hands the previously returned one back to the decode stage.
+    // Returns nullptr when there are no more frames, the previous frame then stays valid.
+    Dataset *pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return !analysedSlots.empty() || !isRunning; });
+        if (analysedSlots.empty()) return nullptr;
+
+        Dataset *slot = analysedSlots.front();
+        if (slot == nullptr) return nullptr;
+        analysedSlots.pop_front();
+
+        if (displayed != nullptr) freeSlots.push_back(displayed);
+        displayed = slot;
+        lock.unlock();
+
+        condition.notify_all();
+        return slot;
+    }
+
+private:
+    // A nullptr queued behind the last frame marks the end of the session
+    void decode(uint32_t firstFrame) {
+        uint32_t prefetchStalls = history->prefetchStalls;
+        for (uint32_t frameIndex = firstFrame;; frameIndex++) {
+            Dataset *slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&] { return !freeSlots.empty() || !isRunning; });
+                if (!isRunning) return;
+
+                slot = freeSlots.front();
+                freeSlots.pop_front();
+            }
+
+            slot->frameIndex = frameIndex;
+            slot->prefetchStalls = prefetchStalls;
+            bool isOk = reader.readFrame(slot);
+            prefetchStalls = slot->prefetchStalls;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (isOk) {
+                    decodedSlots.push_back(slot);
+                } else {
+                    freeSlots.push_back(slot);
+                    decodedSlots.push_back(nullptr);
+                }
+            }
+            condition.notify_all();
+
+            if (!isOk) return;
+        }
+    }
+
+    void analyse() {
+        while (true) {
+            Dataset *slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&] { return !decodedSlots.empty() || !isRunning; });
+                if (!isRunning) return;
+
+                slot = decodedSlots.front();
+                decodedSlots.pop_front();
+            }
+
+            if (slot != nullptr) {
+                swapState(*history, *slot);
+                reader.appendHistory(slot);
+                runCameraAlgorithms(slot, pool);
+                swapState(*slot, *history);
+                slot->vp_visibility = history->vp_visibility;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                analysedSlots.push_back(slot);
+            }
+            condition.notify_all();
+
+            if (slot == nullptr) return;
+        }
+    }
+
+    // State which the algorithms carry from one frame to the next, exchanged without copying
+    static void swapState(Dataset &a, Dataset &b) {
+        std::swap(a.heading, b.heading);
+        std::swap(a.headingDif, b.headingDif);
+        std::swap(a.attitude, b.attitude);
+        std::swap(a.attitudeDif, b.attitudeDif);
+        std::swap(a.vp_visibility, b.vp_visibility);
+        std::swap(a.occlusionBuffers, b.occlusionBuffers);
+    }
+
+    DatasetFileReader &reader;
+    Dataset *history;
+    BS::thread_pool &pool;
+
+    std::vector<std::unique_ptr<Dataset>> slots;
+    Dataset *displayed = nullptr; // Slot returned by the last pop(), it is being rendered
+
+    std::thread decoder;
+    std::thread analyser;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<Dataset *> freeSlots;
+    std::deque<Dataset *> decodedSlots;
+    std::deque<Dataset *> analysedSlots;
+    bool isRunning = false;
+};
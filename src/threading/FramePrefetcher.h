@@ -0,0 +1,252 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "../GlobalConfiguration.h"
+#include "../util/Dataset.h"
+#include "../algorithms/FrameSynchronizer.h"
+#include "../util/KeyframeIndex.h"
+#include "opencv4/opencv2/opencv.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fully decoded frames of all cameras that belong to a single RGB camera frame
+struct FrameSet {
+    cv::Mat leftCameraFrame{};
+    cv::Mat rightCameraFrame{};
+    cv::Mat thermalCameraFrame{};
+
+    // Aligned metadata
+    uint32_t frameIndex = 0;
+    uint32_t thermalFrameIndex = 0;
+    long thermalSyncError = 0;
+
+    // Number of streams which already decoded their frame into this slot
+    int filledStreams = 0;
+};
+
+// Decodes left, right and thermal video streams ahead of the main loop, every stream on its own thread.
+// Decoded frames are stored in a bounded ring of FrameSets which is consumed in order by pop().
+class FramePrefetcher {
+public:
+    enum Stream {
+        Left = 0, Right, Thermal, StreamCount
+    };
+
+    explicit FramePrefetcher(const std::string &sessionPath, size_t depth = FRAME_PREFETCH_DEPTH) : ring(depth) {
+        videoPaths[Left] = sessionPath + std::string(LEFT_VIDEO_PATH);
+        videoPaths[Right] = sessionPath + std::string(RIGHT_VIDEO_PATH);
+        videoPaths[Thermal] = sessionPath + std::string(THERMAL_VIDEO_PATH);
+        for (int stream = 0; stream < StreamCount; stream++) {
+            captures[stream].open(videoPaths[stream]);
+        }
+
+        totalFrames = uint32_t(captures[Left].get(cv::CAP_PROP_FRAME_COUNT));
+    }
+
+    ~FramePrefetcher() { stop(); }
+
+    FramePrefetcher(const FramePrefetcher &) = delete;
+
+    FramePrefetcher &operator=(const FramePrefetcher &) = delete;
+
+    // Frames of the stream are picked by the synchronized indices instead of being read one by one
+    void setStreamSync(Stream stream, StreamSync sync) {
+        streamSyncs[stream] = std::move(sync);
+    }
+
+    void setKeyframeIndex(Stream stream, KeyframeIndex index) {
+        keyframeIndices[stream] = std::move(index);
+    }
+
+    // Frames of the stream are decoded into memory of the allocator, e.g. host visible memory the GPU copies from
+    void setFrameAllocator(Stream stream, cv::MatAllocator *allocator) {
+        frameAllocators[stream] = allocator;
+    }
+
+    // Restarts decoding from any frame. Streams are positioned on the nearest keyframe before their target frame
+    // and decode forward from there, unless they are already between that keyframe and the target.
+    void seek(uint32_t frameIndex) {
+        stop();
+
+        for (int stream = 0; stream < StreamCount; stream++) {
+            uint32_t target = targetFrame(Stream(stream), frameIndex);
+            uint32_t keyframe = keyframeIndices[stream].keyframeBefore(target);
+
+            if (positions[stream] < keyframe || positions[stream] > target) {
+                captures[stream].set(cv::CAP_PROP_POS_FRAMES, keyframe);
+                positions[stream] = keyframe;
+            }
+        }
+
+        start(frameIndex);
+    }
+
+    void start(uint32_t firstFrame) {
+        stop();
+
+        nextSequence = firstFrame;
+        endSequence = totalFrames;
+        for (auto &slot: ring) {
+            slot.filledStreams = 0;
+        }
+
+        isRunning = true;
+        for (int stream = 0; stream < StreamCount; stream++) {
+            decoders.emplace_back(&FramePrefetcher::decodeStream, this, Stream(stream), firstFrame);
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isRunning = false;
+        }
+        producerCondition.notify_all();
+        consumerCondition.notify_all();
+
+        for (auto &decoder: decoders) {
+            decoder.join();
+        }
+        decoders.clear();
+    }
+
+    // Swaps the next decoded frames into the dataset, the previous dataset frames are handed back to the decoders
+    // so their memory gets reused. Returns false when there are no more frames to read.
+    bool pop(Dataset *dataset) {
+        std::unique_lock<std::mutex> lock(mutex);
+        FrameSet &slot = ring[nextSequence % ring.size()];
+
+        auto isReady = [&] { return slot.filledStreams == StreamCount || nextSequence >= endSequence; };
+        if (!isReady()) {
+            auto start = std::chrono::steady_clock::now();
+            consumerCondition.wait(lock, isReady);
+            std::chrono::duration<float> waited = std::chrono::steady_clock::now() - start;
+
+            dataset->prefetchStalls++;
+            dataset->prefetchWait = waited.count() * 1000;
+        } else {
+            dataset->prefetchWait = 0.0f;
+        }
+
+        if (nextSequence >= endSequence) {
+            return false;
+        }
+
+        std::swap(dataset->leftCameraFrame, slot.leftCameraFrame);
+        std::swap(dataset->rightCameraFrame, slot.rightCameraFrame);
+        std::swap(dataset->thermalCameraFrame, slot.thermalCameraFrame);
+        dataset->thermalFrameIndex = slot.thermalFrameIndex;
+        dataset->thermalSyncError = slot.thermalSyncError;
+
+        slot.filledStreams = 0;
+        nextSequence++;
+        lock.unlock();
+
+        producerCondition.notify_all();
+        return true;
+    }
+
+    uint32_t getTotalFrames() const { return totalFrames; }
+
+    const std::string &getVideoPath(Stream stream) const { return videoPaths[stream]; }
+
+    size_t getDepth() const { return ring.size(); }
+
+private:
+    void decodeStream(Stream stream, uint32_t firstFrame) {
+        for (uint32_t sequence = firstFrame;; sequence++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                producerCondition.wait(lock, [&] {
+                    return !isRunning || sequence < nextSequence + ring.size();
+                });
+                if (!isRunning || sequence >= endSequence) return;
+            }
+
+            FrameSet &slot = ring[sequence % ring.size()];
+            bool isOk = decodeFrame(stream, sequence, slot);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (isOk) {
+                    slot.filledStreams++;
+                } else {
+                    endSequence = std::min(endSequence, sequence);
+                }
+            }
+            consumerCondition.notify_one();
+
+            if (!isOk) return;
+        }
+    }
+
+    bool decodeFrame(Stream stream, uint32_t sequence, FrameSet &slot) {
+        switch (stream) {
+            case Left:
+                slot.frameIndex = sequence;
+                return readSynchronized(Left, sequence, slot.leftCameraFrame);
+            case Right:
+                return readSynchronized(Right, sequence, slot.rightCameraFrame);
+            case Thermal:
+                slot.thermalFrameIndex = targetFrame(Thermal, sequence);
+                slot.thermalSyncError = sequence < streamSyncs[Thermal].syncErrors.size()
+                                        ? streamSyncs[Thermal].syncErrors[sequence] : 0;
+                return readSynchronized(Thermal, sequence, slot.thermalCameraFrame);
+            default:
+                return false;
+        }
+    }
+
+    uint32_t targetFrame(Stream stream, uint32_t sequence) const {
+        const auto &indices = streamSyncs[stream].frameIndices;
+        if (indices.empty()) return sequence;
+        return indices[std::min(size_t(sequence), indices.size() - 1)];
+    }
+
+    // Skipped frames are only grabbed, the frame conversion is done just for the matched one.
+    // When the same stream frame matches consecutive reference frames, the last grabbed frame is retrieved again.
+    bool readSynchronized(Stream stream, uint32_t sequence, cv::Mat &frame) {
+        uint32_t target = targetFrame(stream, sequence);
+        while (positions[stream] <= target) {
+            if (!captures[stream].grab()) return false;
+            positions[stream]++;
+        }
+
+        // Frames still referenced elsewhere, e.g. by a GPU upload in flight, get new memory instead of being overwritten
+        cv::MatAllocator *allocator = frameAllocators[stream];
+        if (allocator != nullptr && (frame.u == nullptr || frame.u->currAllocator != allocator || frame.u->refcount > 1)) {
+            frame.release();
+            frame.allocator = allocator;
+        }
+        return captures[stream].retrieve(frame);
+    }
+
+    std::string videoPaths[StreamCount];
+    cv::VideoCapture captures[StreamCount];
+    KeyframeIndex keyframeIndices[StreamCount];
+    StreamSync streamSyncs[StreamCount];
+    std::atomic<cv::MatAllocator *> frameAllocators[StreamCount] = {};
+    uint32_t positions[StreamCount] = {}; // Number of frames grabbed from each stream
+    uint32_t totalFrames = 0;
+
+    std::vector<FrameSet> ring;
+    std::vector<std::thread> decoders;
+
+    std::mutex mutex;
+    std::condition_variable producerCondition;
+    std::condition_variable consumerCondition;
+
+    bool isRunning = false;
+    uint32_t nextSequence = 0;
+    uint32_t endSequence = std::numeric_limits<uint32_t>::max();
+};
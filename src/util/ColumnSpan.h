@@ -0,0 +1,34 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Non-owning read-only view of a contiguous column of values
+template<typename T>
+struct ColumnSpan {
+    const T *values = nullptr;
+    size_t count = 0;
+
+    ColumnSpan() = default;
+
+    ColumnSpan(const T *_values, size_t _count) : values(_values), count(_count) {}
+
+    ColumnSpan(const std::vector<T> &vector) : values(vector.data()), count(vector.size()) {}
+
+    const T &operator[](size_t index) const { return values[index]; }
+
+    const T *data() const { return values; }
+
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    const T &back() const { return values[count - 1]; }
+
+    const T *begin() const { return values; }
+
+    const T *end() const { return values + count; }
+};
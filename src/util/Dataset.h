@@ -6,6 +6,7 @@
 #include "../GlobalConfiguration.h"
 #include "opencv4/opencv2/opencv.hpp"
 #include "../util/circularbuffer.h"
+#include "../util/TimeSeriesStore.h"
 
 struct Dataset {
     // Original variables
@@ -16,17 +17,20 @@ struct Dataset {
 
     // Camera
     uint32_t frameIndex = 0;
+    uint32_t totalFrames = 0;
+    long seekFrameIndex = -1; // Frame requested from the GUI, -1 if there is none
     uint32_t thermalFrameIndex = 0;
+    long thermalSyncError = 0; // Thermal frame timestamp minus camera frame timestamp
     cv::Mat leftCameraFrame{};
     cv::Mat rightCameraFrame{};
     cv::Mat thermalCameraFrame{};
 
     // Inferred variables
-    std::vector<double> heading;
-    std::vector<double> headingDif;
+    TimeSeriesStore heading;
+    TimeSeriesStore headingDif;
 
-    std::vector<double> attitude;
-    std::vector<double> attitudeDif;
+    TimeSeriesStore attitude;
+    TimeSeriesStore attitudeDif;
 
     std::pair<int, int> vanishingPoint{};
 
@@ -34,7 +38,7 @@ struct Dataset {
     bool isDaylight;
 
     // Visibility calculation
-    std::vector<double> vp_visibility;
+    TimeSeriesStore vp_visibility;
     cv::Mat visibility = cv::Mat(DFT_BLOCK_COUNT, DFT_BLOCK_COUNT, CV_32FC1, cv::Scalar(0.0f));
     double visibilityScore = 0.0;
 
@@ -54,6 +58,19 @@ struct Dataset {
     // Timers
     float cameraFrameExtraction, glareAndOcclusionDetection, vanishingPointEstimation, vanishingPointVisibilityCalculation, fogDetection, allCPUAlgorithms, textureGeneration, frameSubmission, rendering;
 
+    // GPU timers, from the timestamp queries of the frame rendered MAX_FRAMES_IN_FLIGHT frames earlier
+    float gpuUnpack = 0.0f, gpuDarkChannel = 0.0f, gpuAirLight = 0.0f, gpuTransmission = 0.0f, gpuGuidedFilter = 0.0f,
+            gpuRadiance = 0.0f, gpuGraphics = 0.0f;
+
+    // Frame prefetching
+    float prefetchWait = 0.0f;
+    uint32_t prefetchStalls = 0;
+
     // Configuration
     bool showVanishingPoint = true, showKeypoints = true;
+    bool useFusedDehaze = FUSED_DEHAZE_ENABLED;
+    bool useTopDarkChannelAirLight = AIRLIGHT_TOP_DARK_CHANNEL_ENABLED;
+    int darkChannelRadius = DARK_CHANNEL_RADIUS;
+    int guidedFilterRadius = GUIDED_FILTER_RADIUS;
+    float guidedFilterEpsilon = GUIDED_FILTER_EPSILON;
 };
\ No newline at end of file
@@ -0,0 +1,42 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Sensor data aligned to every camera frame, stored as a struct of arrays indexed by frame index
+struct FrameMetadataTable {
+    // Nearest IMU and GNSS samples
+    std::vector<uint32_t> imuIndex, gnssIndex;
+
+    // Local time with timezone and daylight savings time applied
+    std::vector<int> year, month, day, hours, minutes, seconds;
+    std::vector<double> dst;
+
+    std::vector<double> latitude, longitude, altitude, azimuth;
+
+    // Inferred variables, differences are against the previous frame and zeroed when out of the allowed range
+    std::vector<double> heading, headingDif;
+    std::vector<double> attitude, attitudeDif;
+
+    std::vector<double> sunrise, sunset;
+    std::vector<uint8_t> isDaylight;
+
+    void resize(size_t frameCount) {
+        imuIndex.resize(frameCount);
+        gnssIndex.resize(frameCount);
+
+        for (auto *column: {&year, &month, &day, &hours, &minutes, &seconds}) {
+            column->resize(frameCount);
+        }
+        for (auto *column: {&dst, &latitude, &longitude, &altitude, &azimuth, &heading, &headingDif, &attitude,
+                            &attitudeDif, &sunrise, &sunset}) {
+            column->resize(frameCount);
+        }
+        isDaylight.resize(frameCount);
+    }
+
+    size_t size() const { return imuIndex.size(); }
+};
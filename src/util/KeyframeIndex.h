@@ -0,0 +1,109 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "SensorLogCache.h"
+#include "opencv4/opencv2/opencv.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Frame indices of the keyframes of a video, used to seek by decoding only from the nearest preceding keyframe
+class KeyframeIndex {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    // Loads the index cached next to the video, or builds and caches it when it is missing or outdated
+    static KeyframeIndex loadOrBuild(const std::string &videoPath) {
+        std::string indexPath = videoPath + ".keyframes";
+        uint64_t stamp = SensorLogCache::sourceStamp({videoPath});
+
+        KeyframeIndex index;
+        if (index.load(indexPath, stamp)) return index;
+
+        index = build(videoPath);
+        if (!index.keyframes.empty()) {
+            index.save(indexPath, stamp);
+        }
+        return index;
+    }
+
+    // Demuxes the video without decoding and records which packets are keyframes
+    static KeyframeIndex build(const std::string &videoPath) {
+        KeyframeIndex index;
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)))
+        cv::VideoCapture capture(videoPath, cv::CAP_FFMPEG);
+        if (!capture.isOpened() || !capture.set(cv::CAP_PROP_FORMAT, -1)) return index;
+
+        uint32_t frame = 0;
+        while (capture.grab()) {
+            if (capture.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0) {
+                index.keyframes.push_back(frame);
+            }
+            frame++;
+        }
+        index.frameCount = frame;
+#endif
+        return index;
+    }
+
+    // Nearest keyframe at or before the frame. Without an index the frame itself is returned and the seek is left to OpenCV.
+    uint32_t keyframeBefore(uint32_t frame) const {
+        auto next = std::upper_bound(keyframes.begin(), keyframes.end(), frame);
+        if (next == keyframes.begin()) return keyframes.empty() ? frame : 0;
+        return *(next - 1);
+    }
+
+    bool empty() const { return keyframes.empty(); }
+
+    uint32_t getFrameCount() const { return frameCount; }
+
+private:
+    static constexpr char MAGIC[8] = {'V', 'C', 'E', 'K', 'E', 'Y', 'F', '\0'};
+
+    bool load(const std::string &path, uint64_t stamp) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+
+        char magic[8];
+        uint32_t version = 0, count = 0;
+        uint64_t fileStamp = 0;
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char *>(&version), sizeof(version));
+        file.read(reinterpret_cast<char *>(&fileStamp), sizeof(fileStamp));
+        file.read(reinterpret_cast<char *>(&frameCount), sizeof(frameCount));
+        file.read(reinterpret_cast<char *>(&count), sizeof(count));
+        if (!file || std::memcmp(magic, MAGIC, sizeof(magic)) != 0 || version != VERSION || fileStamp != stamp) {
+            return false;
+        }
+
+        keyframes.resize(count);
+        file.read(reinterpret_cast<char *>(keyframes.data()), std::streamsize(count * sizeof(uint32_t)));
+        if (!file) {
+            keyframes.clear();
+            return false;
+        }
+        return true;
+    }
+
+    void save(const std::string &path, uint64_t stamp) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return;
+
+        auto count = uint32_t(keyframes.size());
+        file.write(MAGIC, sizeof(MAGIC));
+        file.write(reinterpret_cast<const char *>(&VERSION), sizeof(VERSION));
+        file.write(reinterpret_cast<const char *>(&stamp), sizeof(stamp));
+        file.write(reinterpret_cast<const char *>(&frameCount), sizeof(frameCount));
+        file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char *>(keyframes.data()), std::streamsize(count * sizeof(uint32_t)));
+    }
+
+    std::vector<uint32_t> keyframes;
+    uint32_t frameCount = 0;
+};
@@ -0,0 +1,212 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "ColumnSpan.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(long) == sizeof(int64_t), "Timestamp columns are stored as 64-bit integers");
+
+// Columnar binary copy of the session sensor logs.
+// File layout: header, column table, then every column as a raw 64-byte aligned array.
+class SensorLogCache {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    enum ColumnType : uint32_t {
+        Integer = 0, Real = 1
+    };
+
+    // Column of the source data which should be written into the cache
+    struct ColumnSource {
+        std::string name;
+        ColumnType type;
+        const void *values;
+        size_t count;
+
+        ColumnSource(std::string _name, const std::vector<long> &column) : name(std::move(_name)), type(Integer),
+                                                                            values(column.data()),
+                                                                            count(column.size()) {}
+
+        ColumnSource(std::string _name, const std::vector<double> &column) : name(std::move(_name)), type(Real),
+                                                                              values(column.data()),
+                                                                              count(column.size()) {}
+    };
+
+    SensorLogCache() = default;
+
+    ~SensorLogCache() { close(); }
+
+    SensorLogCache(const SensorLogCache &) = delete;
+
+    SensorLogCache &operator=(const SensorLogCache &) = delete;
+
+    // Identifies the source files by their size and modification time, the cache is rebuilt when any of them changes
+    static uint64_t sourceStamp(const std::vector<std::string> &sourcePaths) {
+        uint64_t stamp = 14695981039346656037ull;
+        auto mix = [&stamp](uint64_t value) {
+            stamp ^= value;
+            stamp *= 1099511628211ull;
+        };
+
+        for (const auto &path: sourcePaths) {
+            struct stat fileStat{};
+            if (stat(path.c_str(), &fileStat) != 0) {
+                mix(0);
+                continue;
+            }
+            mix(uint64_t(fileStat.st_size));
+            mix(uint64_t(fileStat.st_mtime));
+        }
+        return stamp;
+    }
+
+    static bool write(const std::string &path, uint64_t stamp, const std::vector<ColumnSource> &columns) {
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.columnCount = uint32_t(columns.size());
+        header.sourceStamp = stamp;
+
+        std::vector<Column> table(columns.size());
+        uint64_t dataEnd = sizeof(Header) + sizeof(Column) * columns.size();
+        uint64_t offset = align(dataEnd);
+        for (size_t i = 0; i < columns.size(); i++) {
+            std::strncpy(table[i].name, columns[i].name.c_str(), sizeof(table[i].name) - 1);
+            table[i].type = columns[i].type;
+            table[i].offset = offset;
+            table[i].count = columns[i].count;
+            dataEnd = offset + columns[i].count * 8;
+            offset = align(dataEnd);
+        }
+
+        // Written under a temporary name first, so an interrupted conversion never leaves a truncated cache behind
+        std::string temporaryPath = path + ".tmp";
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char *>(table.data()), std::streamsize(sizeof(Column) * table.size()));
+        for (size_t i = 0; i < columns.size(); i++) {
+            file.seekp(std::streamoff(table[i].offset));
+            file.write(static_cast<const char *>(columns[i].values), std::streamsize(columns[i].count * 8));
+        }
+        // Pad the file, so the last column is fully inside the mapping. Already aligned data needs no padding,
+        // the last byte would belong to the last value.
+        if (offset > dataEnd) {
+            file.seekp(std::streamoff(offset - 1));
+            file.put(0);
+        }
+        file.close();
+
+        if (!file) return false;
+        return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+
+    // Maps the cache into memory, fails if it is missing, of a different version or built from different sources
+    bool open(const std::string &path, uint64_t stamp) {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat fileStat{};
+        if (fstat(fd, &fileStat) != 0 || size_t(fileStat.st_size) < sizeof(Header)) {
+            ::close(fd);
+            return false;
+        }
+
+        mappedSize = size_t(fileStat.st_size);
+        void *mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            mappedSize = 0;
+            return false;
+        }
+        mapped = static_cast<const uint8_t *>(mapping);
+
+        const auto *header = reinterpret_cast<const Header *>(mapped);
+        bool isValid = std::memcmp(header->magic, MAGIC, sizeof(header->magic)) == 0 &&
+                       header->version == VERSION && header->sourceStamp == stamp &&
+                       sizeof(Header) + sizeof(Column) * header->columnCount <= mappedSize;
+
+        if (isValid) {
+            columns = reinterpret_cast<const Column *>(mapped + sizeof(Header));
+            columnCount = header->columnCount;
+            for (uint32_t i = 0; i < columnCount; i++) {
+                isValid &= columns[i].offset + columns[i].count * 8 <= mappedSize;
+            }
+        }
+
+        if (!isValid) close();
+        return isValid;
+    }
+
+    void close() {
+        if (mapped != nullptr) {
+            munmap(const_cast<uint8_t *>(mapped), mappedSize);
+        }
+        mapped = nullptr;
+        mappedSize = 0;
+        columns = nullptr;
+        columnCount = 0;
+    }
+
+    ColumnSpan<long> integerColumn(const std::string &name) const {
+        const Column *column = find(name, Integer);
+        if (column == nullptr) return {};
+        return {reinterpret_cast<const long *>(mapped + column->offset), size_t(column->count)};
+    }
+
+    ColumnSpan<double> realColumn(const std::string &name) const {
+        const Column *column = find(name, Real);
+        if (column == nullptr) return {};
+        return {reinterpret_cast<const double *>(mapped + column->offset), size_t(column->count)};
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'V', 'C', 'E', 'S', 'L', 'O', 'G', '\0'};
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t columnCount;
+        uint64_t sourceStamp;
+    };
+
+    struct Column {
+        char name[24];
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    static uint64_t align(uint64_t offset) { return (offset + 63) & ~uint64_t(63); }
+
+    const Column *find(const std::string &name, ColumnType type) const {
+        for (uint32_t i = 0; i < columnCount; i++) {
+            if (columns[i].type == type && name == columns[i].name) {
+                return &columns[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const uint8_t *mapped = nullptr;
+    size_t mappedSize = 0;
+    const Column *columns = nullptr;
+    uint32_t columnCount = 0;
+};
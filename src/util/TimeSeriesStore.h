@@ -0,0 +1,192 @@
+//
+// Created by standa on 16.10.26.
+//
+#pragma once
+
+#include "../GlobalConfiguration.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Appends values to a binary file of raw doubles on a background thread
+class TimeSeriesSpill {
+public:
+    explicit TimeSeriesSpill(const std::string &path) : file(path, std::ios::binary | std::ios::trunc) {
+        writer = std::thread(&TimeSeriesSpill::write, this);
+    }
+
+    ~TimeSeriesSpill() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isRunning = false;
+        }
+        condition.notify_one();
+        writer.join();
+    }
+
+    TimeSeriesSpill(const TimeSeriesSpill &) = delete;
+
+    TimeSeriesSpill &operator=(const TimeSeriesSpill &) = delete;
+
+    void append(double value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(value);
+        if (pending.size() >= CHUNK_SIZE) condition.notify_one();
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    void write() {
+        std::vector<double> chunk;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            condition.wait(lock, [&] { return !isRunning || pending.size() >= CHUNK_SIZE; });
+            chunk.swap(pending);
+            bool isLast = !isRunning;
+
+            lock.unlock();
+            file.write(reinterpret_cast<const char *>(chunk.data()), std::streamsize(chunk.size() * sizeof(double)));
+            chunk.clear();
+            lock.lock();
+
+            if (isLast) break;
+        }
+        file.flush();
+    }
+
+    std::ofstream file;
+    std::thread writer;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<double> pending;
+    bool isRunning = true;
+};
+
+// Fixed-size history of a per-frame value. The most recent values are kept at full resolution,
+// older ones are folded into min/max/mean buckets whose width doubles whenever the bucket list fills up.
+// Optionally every value is also spilled to a file, so the full history is still available after the run.
+class TimeSeriesStore {
+public:
+    struct Bucket {
+        size_t firstIndex = 0;
+        size_t count = 0;
+        double min = std::numeric_limits<double>::max();
+        double max = std::numeric_limits<double>::lowest();
+        double sum = 0.0;
+
+        double mean() const { return count > 0 ? sum / double(count) : 0.0; }
+
+        void add(double value) {
+            min = std::min(min, value);
+            max = std::max(max, value);
+            sum += value;
+            count++;
+        }
+
+        void merge(const Bucket &other) {
+            min = std::min(min, other.min);
+            max = std::max(max, other.max);
+            sum += other.sum;
+            count += other.count;
+        }
+    };
+
+    explicit TimeSeriesStore(size_t _recentCapacity = TIMESERIES_RECENT_CAPACITY,
+                             size_t _bucketCapacity = TIMESERIES_BUCKET_CAPACITY)
+            : recentCapacity(std::max<size_t>(_recentCapacity, 1)),
+              bucketCapacity(std::max<size_t>((_bucketCapacity + 1) & ~size_t(1), 2)), recent(recentCapacity) {
+        buckets.reserve(bucketCapacity);
+    }
+
+    void enableSpill(const std::string &path) {
+        spill = std::make_shared<TimeSeriesSpill>(path);
+    }
+
+    // Flushes and closes the spill file, following values are only kept in memory
+    void disableSpill() {
+        spill.reset();
+    }
+
+    void push_back(double value) {
+        if (recentSize == recentCapacity) {
+            evict(recent[recentStart]);
+            recentStart = (recentStart + 1) % recentCapacity;
+            recentSize--;
+        }
+        recent[(recentStart + recentSize) % recentCapacity] = value;
+        recentSize++;
+        totalSize++;
+
+        if (spill) spill->append(value);
+    }
+
+    void emplace_back(double value) { push_back(value); }
+
+    double back() const { return recent[(recentStart + recentSize - 1) % recentCapacity]; }
+
+    bool empty() const { return totalSize == 0; }
+
+    // Number of values pushed over the whole run
+    size_t size() const { return totalSize; }
+
+    size_t getRecentSize() const { return recentSize; }
+
+    // Value of the recent window, 0 is the oldest one still kept at full resolution
+    double recentAt(size_t i) const { return recent[(recentStart + i) % recentCapacity]; }
+
+    // Index of the oldest full-resolution value within the whole run
+    size_t getRecentFirstIndex() const { return totalSize - recentSize; }
+
+    // Summaries of everything older than the recent window, including the bucket which is still being filled
+    std::vector<Bucket> getBuckets() const {
+        std::vector<Bucket> result = buckets;
+        if (pendingBucket.count > 0) result.push_back(pendingBucket);
+        return result;
+    }
+
+private:
+    void evict(double value) {
+        if (pendingBucket.count == 0) {
+            pendingBucket = Bucket();
+            pendingBucket.firstIndex = totalSize - recentSize;
+        }
+        pendingBucket.add(value);
+        if (pendingBucket.count < bucketWidth) return;
+
+        buckets.push_back(pendingBucket);
+        pendingBucket = Bucket();
+
+        // Halve the resolution of the old data when the bucket list is full
+        if (buckets.size() == bucketCapacity) {
+            for (size_t i = 0; i < buckets.size() / 2; i++) {
+                buckets[i] = buckets[2 * i];
+                buckets[i].merge(buckets[2 * i + 1]);
+            }
+            buckets.resize(buckets.size() / 2);
+            bucketWidth *= 2;
+        }
+    }
+
+    size_t recentCapacity;
+    size_t bucketCapacity;
+
+    std::vector<double> recent;
+    size_t recentStart = 0;
+    size_t recentSize = 0;
+    size_t totalSize = 0;
+
+    std::vector<Bucket> buckets;
+    Bucket pendingBucket{};
+    size_t bucketWidth = 1;
+
+    std::shared_ptr<TimeSeriesSpill> spill;
+};